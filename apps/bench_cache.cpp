@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cache/cache_model.h"
+#include "cache/replacement_policy.h"
+
+// Throughput microbenchmarks for the simulator itself. Every benchmark
+// replays a pre-generated address array through one Cache, so only the
+// simulator's own work is timed: per-reference Cache::access calls
+// ("access") and 4096-reference Cache::access_batch calls ("batch"). Each
+// measurement is the median over --reps timed replays after one untimed
+// warmup replay; the cache is reset and flushed before every replay so all
+// of them simulate identical work.
+
+// -----------------------------
+// Trace shapes
+// -----------------------------
+
+// Modelled on the run_experiments generators; each fills exactly `refs`
+// addresses so that ns/access is comparable across shapes.
+enum class Shape {
+    Stream,     // sequential 4-byte steps, no reuse
+    Reuse,      // 24 KB working set, looped
+    Conflict,   // assoc + 1 lines mapping to one set, round robin
+    Random      // uniform over 4x the cache size
+};
+
+static const char* shape_name(Shape s) {
+    switch (s) {
+        case Shape::Stream:   return "stream";
+        case Shape::Reuse:    return "reuse";
+        case Shape::Conflict: return "conflict";
+        case Shape::Random:   return "random";
+    }
+    return "unknown";
+}
+
+static std::vector<uint64_t> make_trace(Shape shape, size_t refs, size_t cache_size, size_t assoc) {
+    std::vector<uint64_t> out(refs);
+    switch (shape) {
+        case Shape::Stream:
+            for (size_t i = 0; i < refs; i++) out[i] = 4 * static_cast<uint64_t>(i);
+            break;
+        case Shape::Reuse: {
+            const uint64_t ws = 24 * 1024;
+            for (size_t i = 0; i < refs; i++) out[i] = (4 * static_cast<uint64_t>(i)) % ws;
+            break;
+        }
+        case Shape::Conflict: {
+            const uint64_t hot = assoc + 1;
+            for (size_t i = 0; i < refs; i++) out[i] = (i % hot) * cache_size;
+            break;
+        }
+        case Shape::Random: {
+            uint64_t state = 0x2545f4914f6cdd1dULL;
+            const uint64_t span = 4 * static_cast<uint64_t>(cache_size);
+            for (size_t i = 0; i < refs; i++) out[i] = xorshift64star(state) % span;
+            break;
+        }
+    }
+    return out;
+}
+
+// -----------------------------
+// Benchmarks
+// -----------------------------
+
+struct BenchSpec {
+    std::string group;
+    Shape shape = Shape::Random;
+    ReplacementPolicy policy = ReplacementPolicy::LRU;
+    size_t cache_size = 32 * 1024;
+    size_t line_size = 64;
+    size_t assoc = 8;
+
+    std::string name() const {
+        return group + "/" + shape_name(shape) + "/" + replacement_policy_name(policy) + "/" +
+               std::to_string(cache_size / 1024) + "k/" + std::to_string(line_size) + "B/" +
+               std::to_string(assoc) + "w";
+    }
+};
+
+struct BenchResult {
+    double ns_median = 0.0;
+    double ns_min = 0.0;
+    double miss_rate = 0.0;
+};
+
+enum class Mode { Access, Batch };
+
+// Keeps the per-reference latencies of the access loop observable.
+static volatile uint64_t latency_sink = 0;
+
+static const char* mode_name(Mode m) { return m == Mode::Access ? "access" : "batch"; }
+
+// One replay of `trace`; returns the elapsed seconds.
+static double replay(Cache& c, const std::vector<uint64_t>& trace, Mode mode) {
+    c.reset_stats();
+    c.flush();
+
+    const auto t0 = std::chrono::steady_clock::now();
+    if (mode == Mode::Access) {
+        uint64_t latency = 0;
+        uint64_t sum = 0;
+        for (uint64_t a : trace) {
+            c.access(a, latency);
+            sum += latency;
+        }
+        latency_sink = sum;
+    } else {
+        constexpr size_t kBatch = 4096;
+        for (size_t off = 0; off < trace.size(); off += kBatch) {
+            c.access_batch(trace.data() + off, std::min(kBatch, trace.size() - off));
+        }
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+static BenchResult run_bench(const BenchSpec& b, Mode mode, const std::vector<uint64_t>& trace, size_t reps) {
+    Cache c(b.cache_size, b.line_size, b.assoc, 1, 100, b.policy);
+    replay(c, trace, mode);     // warmup: page in tags, train the branch predictors
+
+    std::vector<double> ns(reps);
+    for (size_t r = 0; r < reps; r++) {
+        ns[r] = replay(c, trace, mode) * 1e9 / static_cast<double>(trace.size());
+    }
+    std::sort(ns.begin(), ns.end());
+
+    BenchResult res;
+    res.ns_median = ns[reps / 2];
+    res.ns_min = ns.front();
+    res.miss_rate = c.get_miss_rate();
+    return res;
+}
+
+static std::vector<BenchSpec> all_benches() {
+    static const ReplacementPolicy kPolicies[] = {
+        ReplacementPolicy::LRU, ReplacementPolicy::FIFO, ReplacementPolicy::RANDOM,
+        ReplacementPolicy::TREE_PLRU, ReplacementPolicy::BIT_PLRU,
+        ReplacementPolicy::SRRIP, ReplacementPolicy::BRRIP,
+    };
+    static const Shape kShapes[] = {Shape::Stream, Shape::Reuse, Shape::Conflict, Shape::Random};
+
+    std::vector<BenchSpec> out;
+    for (size_t assoc : {1, 2, 4, 8, 16, 32, 64}) {
+        for (Shape s : {Shape::Reuse, Shape::Random}) {
+            BenchSpec b;
+            b.group = "assoc";
+            b.shape = s;
+            b.assoc = assoc;
+            out.push_back(b);
+        }
+    }
+    for (ReplacementPolicy pol : kPolicies) {
+        for (Shape s : kShapes) {
+            BenchSpec b;
+            b.group = "policy";
+            b.shape = s;
+            b.policy = pol;
+            out.push_back(b);
+        }
+    }
+    // One set holding every line: the hash-indexed fully-associative path.
+    for (ReplacementPolicy pol : {ReplacementPolicy::LRU, ReplacementPolicy::FIFO, ReplacementPolicy::RANDOM}) {
+        for (Shape s : {Shape::Reuse, Shape::Random}) {
+            BenchSpec b;
+            b.group = "fully_assoc";
+            b.shape = s;
+            b.policy = pol;
+            b.assoc = b.cache_size / b.line_size;
+            out.push_back(b);
+        }
+    }
+    for (size_t line : {16, 32, 64, 128, 256}) {
+        for (Shape s : {Shape::Stream, Shape::Random}) {
+            BenchSpec b;
+            b.group = "line_size";
+            b.shape = s;
+            b.line_size = line;
+            b.assoc = 4;
+            out.push_back(b);
+        }
+    }
+    return out;
+}
+
+// -----------------------------
+// Driver
+// -----------------------------
+
+// Value following `flag` on the command line, or "" if absent.
+static std::string parse_option(int argc, char** argv, const std::string& flag) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (flag == argv[i]) return argv[i + 1];
+    }
+    return "";
+}
+
+// Positive whole-number value of `flag`, or `fallback` if absent. Throws
+// std::runtime_error for anything else (a sign, junk, zero, overflow).
+static size_t parse_count_option(int argc, char** argv, const std::string& flag, size_t fallback) {
+    const std::string s = parse_option(argc, argv, flag);
+    if (s.empty()) return fallback;
+    size_t used = 0;
+    unsigned long long n = 0;
+    try {
+        if (!std::isdigit(static_cast<unsigned char>(s[0]))) throw std::invalid_argument(s);
+        n = std::stoull(s, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != s.size() || n == 0 || n > std::numeric_limits<size_t>::max()) {
+        throw std::runtime_error(flag + " expects a positive number, got '" + s + "'");
+    }
+    return static_cast<size_t>(n);
+}
+
+static const char* kUsage =
+    "usage: bench_cache [--refs N] [--reps N] [--filter S] [--csv PATH|-]\n";
+
+int main(int argc, char** argv) {
+    // --refs N     references per replay (default 2M)
+    // --reps N     timed replays per benchmark (default 5)
+    // --filter S   only benchmarks whose name contains S
+    // --csv PATH   also write machine-readable results ("-" = stdout only)
+    size_t refs = 0;
+    size_t reps = 0;
+    try {
+        refs = parse_count_option(argc, argv, "--refs", 2000000);
+        reps = parse_count_option(argc, argv, "--reps", 5);
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n" << kUsage;
+        return 1;
+    }
+    const std::string filter = parse_option(argc, argv, "--filter");
+    const std::string csv_path = parse_option(argc, argv, "--csv");
+
+    const bool csv_stdout = csv_path == "-";
+    std::ofstream csv_file;
+    if (!csv_path.empty() && !csv_stdout) {
+        csv_file.open(csv_path);
+        if (!csv_file) {
+            std::cerr << "cannot write " << csv_path << "\n";
+            return 1;
+        }
+    }
+    std::ostream& csv = csv_stdout ? std::cout : csv_file;
+    const bool want_csv = !csv_path.empty();
+
+    if (want_csv) {
+        csv << "name,mode,trace,policy,cache_kb,line_size,assoc,refs,reps,"
+               "ns_per_access,ns_per_access_min,accesses_per_sec,miss_rate\n";
+    }
+    if (!csv_stdout) {
+        std::cout << std::left << std::setw(40) << "benchmark" << std::setw(8) << "mode"
+                  << std::right << std::setw(10) << "ns/acc" << std::setw(10) << "min"
+                  << std::setw(12) << "Macc/s" << std::setw(10) << "miss" << "\n";
+    }
+
+    size_t run = 0;
+    for (const BenchSpec& b : all_benches()) {
+        const std::string name = b.name();
+        if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+        run++;
+
+        const std::vector<uint64_t> trace = make_trace(b.shape, refs, b.cache_size, b.assoc);
+        for (Mode mode : {Mode::Access, Mode::Batch}) {
+            const BenchResult r = run_bench(b, mode, trace, reps);
+            const double per_sec = 1e9 / r.ns_median;
+
+            if (!csv_stdout) {
+                std::cout << std::left << std::setw(40) << name << std::setw(8) << mode_name(mode)
+                          << std::right << std::fixed
+                          << std::setw(10) << std::setprecision(2) << r.ns_median
+                          << std::setw(10) << std::setprecision(2) << r.ns_min
+                          << std::setw(12) << std::setprecision(1) << per_sec / 1e6
+                          << std::setw(10) << std::setprecision(4) << r.miss_rate << "\n";
+            }
+            if (want_csv) {
+                csv << name << "," << mode_name(mode) << "," << shape_name(b.shape) << ","
+                    << replacement_policy_name(b.policy) << "," << b.cache_size / 1024 << ","
+                    << b.line_size << "," << b.assoc << "," << refs << "," << reps << ","
+                    << std::fixed << std::setprecision(3) << r.ns_median << ","
+                    << std::setprecision(3) << r.ns_min << ","
+                    << std::setprecision(0) << per_sec << ","
+                    << std::setprecision(6) << r.miss_rate << "\n";
+            }
+        }
+    }
+
+    if (run == 0) {
+        std::cerr << "no benchmark matches --filter " << filter << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,312 +1,1074 @@
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <iomanip>
 
 #include "cache/cache_model.h"
+#include "cache/host_counters.h"
+#include "cache/multi_cache.h"
 #include "cache/replacement_policy.h"
+#include "cache/stack_distance.h"
+#include "cache/synthetic_trace.h"
+#include "cache/thread_pool.h"
+#include "cache/timing.h"
+#include "cache/trace_pipeline.h"
+#include "cache/trace_source.h"
 
 // -----------------------------
-// Trace patterns
+// Sweep points
 // -----------------------------
 
-// Streaming sequential: strong spatial locality, minimal temporal reuse.
-static void trace_stream_sequential(Cache& cache, uint64_t bytes, uint64_t step_bytes) {
-    uint64_t lat = 0;
-    for (uint64_t addr = 0; addr < bytes; addr += step_bytes) {
-        cache.access(addr, lat);
-    }
-}
+enum class TraceKind {
+    StreamSequential,
+    ReuseWorkingSet,
+    SameSetConflict,
+    Stride,
+    File
+};
+
+// Everything needed to regenerate a trace. Points with equal keys see
+// exactly the same references.
+struct TraceSpec {
+    TraceKind kind = TraceKind::ReuseWorkingSet;
+    uint64_t bytes = 0;         // stream length, working set, or conflict spacing
+    uint64_t step_bytes = 0;    // step or stride
+    uint64_t repeat = 0;        // passes (reuse) or hot lines (conflict)
+    uint64_t accesses = 0;      // length of conflict / stride traces
+    std::string path;           // File
 
-// Reuse working set: shows capacity effects (cache size matters).
-static void trace_reuse_working_set(Cache& cache, uint64_t working_set_bytes, uint64_t step_bytes, uint64_t passes) {
-    uint64_t lat = 0;
-    for (uint64_t p = 0; p < passes; p++) {
-        for (uint64_t addr = 0; addr < working_set_bytes; addr += step_bytes) {
-            cache.access(addr, lat);
+    // Value of the trace column in results.csv.
+    std::string name() const {
+        switch (kind) {
+            case TraceKind::StreamSequential: return "stream_sequential";
+            case TraceKind::ReuseWorkingSet:  return "reuse_working_set";
+            case TraceKind::SameSetConflict:  return "same_set_conflict";
+            case TraceKind::Stride:           return "stride_walk";
+            case TraceKind::File:             return path;
         }
+        return "unknown";
     }
-}
 
-// Same-set conflict: demonstrates associativity/policy differences.
-// Addresses spaced cache_size apart map to same set for typical indexing.
-static void trace_same_set_conflict(Cache& cache, uint64_t cache_size_bytes, uint64_t hot_lines, uint64_t accesses) {
-    uint64_t lat = 0;
-    std::vector<uint64_t> addrs;
-    addrs.reserve(hot_lines);
-    for (uint64_t i = 0; i < hot_lines; i++) {
-        addrs.push_back(i * cache_size_bytes);
+    std::string key() const {
+        return name() + ":" + std::to_string(bytes) + ":" + std::to_string(step_bytes) + ":" +
+               std::to_string(repeat) + ":" + std::to_string(accesses);
     }
+};
+
+static TraceSpec stream_trace(uint64_t bytes, uint64_t step_bytes) {
+    TraceSpec t;
+    t.kind = TraceKind::StreamSequential;
+    t.bytes = bytes;
+    t.step_bytes = step_bytes;
+    return t;
+}
 
-    for (uint64_t i = 0; i < accesses; i++) {
-        cache.access(addrs[i % addrs.size()], lat);
+static TraceSpec reuse_trace(uint64_t working_set_bytes, uint64_t step_bytes, uint64_t passes) {
+    TraceSpec t;
+    t.kind = TraceKind::ReuseWorkingSet;
+    t.bytes = working_set_bytes;
+    t.step_bytes = step_bytes;
+    t.repeat = passes;
+    return t;
+}
+
+static TraceSpec conflict_trace(uint64_t cache_size_bytes, uint64_t hot_lines, uint64_t accesses) {
+    TraceSpec t;
+    t.kind = TraceKind::SameSetConflict;
+    t.bytes = cache_size_bytes;
+    t.repeat = hot_lines;
+    t.accesses = accesses;
+    return t;
+}
+
+static TraceSpec stride_trace(uint64_t working_set_bytes, uint64_t stride_bytes, uint64_t accesses) {
+    TraceSpec t;
+    t.kind = TraceKind::Stride;
+    t.bytes = working_set_bytes;
+    t.step_bytes = stride_bytes;
+    t.accesses = accesses;
+    return t;
+}
+
+static TraceSpec file_trace(const std::string& path) {
+    TraceSpec t;
+    t.kind = TraceKind::File;
+    t.path = path;
+    return t;
+}
+
+static std::unique_ptr<TraceSource> open_trace(const TraceSpec& t) {
+    switch (t.kind) {
+        case TraceKind::StreamSequential: return std::make_unique<StreamTraceSource>(t.bytes, t.step_bytes);
+        case TraceKind::ReuseWorkingSet:  return std::make_unique<ReuseTraceSource>(t.bytes, t.step_bytes, t.repeat);
+        case TraceKind::SameSetConflict:  return std::make_unique<ConflictTraceSource>(t.bytes, t.repeat, t.accesses);
+        case TraceKind::Stride:           return std::make_unique<StrideTraceSource>(t.bytes, t.step_bytes, t.accesses);
+        case TraceKind::File:             return open_trace_file(t.path);
     }
+    throw std::invalid_argument("unknown trace kind");
+}
+
+// Feeds the whole trace to a sink (a cache, MultiCacheDriver or
+// StackDistanceAnalyzer) chunk by chunk. With `prefetch`, the trace is
+// generated or read on its own thread, ahead of the simulation.
+template <typename Sink>
+static void run_trace(const TraceSpec& t, Sink& sink, bool prefetch) {
+    std::unique_ptr<TraceSource> source = open_trace(t);
+    std::unique_ptr<PrefetchingTraceSource> pipeline;
+    if (prefetch) pipeline = std::make_unique<PrefetchingTraceSource>(*source);
+    TraceSource& in = pipeline ? static_cast<TraceSource&>(*pipeline) : *source;
+
+    TraceChunk chunk;
+    while (in.next(chunk)) sink.access_batch(chunk.addresses, chunk.count);
 }
 
-// Stride walk within a working set: can show spatial locality effects + set conflicts depending on stride.
-static void trace_stride(Cache& cache, uint64_t working_set_bytes, uint64_t stride_bytes, uint64_t accesses) {
-    uint64_t lat = 0;
-    uint64_t addr = 0;
-    for (uint64_t i = 0; i < accesses; i++) {
-        cache.access(addr, lat);
-        addr = (addr + stride_bytes) % working_set_bytes;
+// Parameters that determine hit/miss behavior.
+struct CacheGeometry {
+    size_t cache_size = 0;
+    size_t line_size = 0;
+    size_t assoc = 0;
+    ReplacementPolicy policy = ReplacementPolicy::LRU;
+
+    size_t num_sets() const { return cache_size / (line_size * assoc); }
+
+    std::string key() const {
+        return std::to_string(cache_size) + ":" + std::to_string(line_size) + ":" +
+               std::to_string(assoc) + ":" + std::to_string(static_cast<int>(policy));
     }
+};
+
+struct PointSpec {
+    std::string experiment;
+    CacheGeometry cache;
+    TimingParams timing;
+    TraceSpec trace;
+
+    // Labels for results.csv only.
+    uint64_t working_set_kb = 0;
+    uint64_t stride_bytes = 0;
+};
+
+static TimingParams fixed_timing(size_t hit_latency, size_t miss_penalty) {
+    TimingParams t;
+    t.hit_latency = hit_latency;
+    t.miss_penalty = miss_penalty;
+    return t;
+}
+
+// miss_penalty is only the CSV label here; misses are costed by `mem`.
+static TimingParams memory_timing(size_t hit_latency, size_t miss_penalty, const MemoryTiming& mem) {
+    TimingParams t = fixed_timing(hit_latency, miss_penalty);
+    t.mem_timing = mem;
+    t.use_mem_timing = true;
+    return t;
 }
 
 // -----------------------------
 // Helpers
 // -----------------------------
 
-static const char* policy_name(ReplacementPolicy p) {
-    switch (p) {
-        case ReplacementPolicy::LRU:    return "LRU";
-        case ReplacementPolicy::FIFO:   return "FIFO";
-        case ReplacementPolicy::RANDOM: return "RANDOM";
-        default:                        return "UNKNOWN";
+static const ReplacementPolicy kAllPolicies[] = {
+    ReplacementPolicy::LRU, ReplacementPolicy::FIFO, ReplacementPolicy::RANDOM,
+    ReplacementPolicy::TREE_PLRU, ReplacementPolicy::BIT_PLRU,
+    ReplacementPolicy::SRRIP, ReplacementPolicy::BRRIP,
+};
+
+// Host-side cost of the functional pass that produced a row. A pass
+// simulates `configs` geometries over one trace, so per-access figures
+// divide by trace references times configs.
+struct PassCost {
+    double seconds = 0.0;
+    size_t configs = 1;
+    bool counted = false;           // host counters were read
+    HostCounters::Sample host;
+};
+
+// Runs pass() on the calling thread and measures it; with use_counters the
+// perf_event counters are read too, when the host allows it.
+template <typename F>
+static PassCost measure_pass(bool use_counters, size_t configs, F&& pass) {
+    std::unique_ptr<HostCounters> counters;
+    if (use_counters) {
+        counters.reset(new HostCounters());
+        if (!counters->valid()) counters.reset();
     }
+
+    PassCost cost;
+    cost.configs = configs;
+    if (counters) counters->start();
+    const auto t0 = std::chrono::steady_clock::now();
+    pass();
+    const auto t1 = std::chrono::steady_clock::now();
+    if (counters) {
+        cost.host = counters->stop();
+        cost.counted = true;
+    }
+    cost.seconds = std::chrono::duration<double>(t1 - t0).count();
+    return cost;
 }
 
-static void write_row(std::ofstream& out,
-                      const std::string& experiment,
-                      size_t cache_kb,
-                      size_t line_size,
-                      size_t assoc,
-                      size_t hit_latency,
-                      size_t miss_penalty,
-                      ReplacementPolicy pol,
-                      const std::string& trace_name,
-                      uint64_t working_set_kb,
-                      uint64_t stride_bytes,
-                      double miss_rate,
-                      double amat,
-                      uint64_t hits,
-                      uint64_t misses) {
-    out << experiment << ","
-        << cache_kb << ","
-        << line_size << ","
-        << assoc << ","
-        << hit_latency << ","
-        << miss_penalty << ","
-        << policy_name(pol) << ","
-        << trace_name << ","
-        << working_set_kb << ","
-        << stride_bytes << ","
-        << std::fixed << std::setprecision(6) << miss_rate << ","
-        << std::fixed << std::setprecision(3) << amat << ","
-        << hits << ","
-        << misses
-        << "\n";
+// One line of results.csv.
+struct ResultRow {
+    std::string experiment;
+    size_t cache_kb = 0;
+    size_t line_size = 0;
+    size_t assoc = 0;
+    size_t hit_latency = 0;
+    size_t miss_penalty = 0;
+    ReplacementPolicy pol = ReplacementPolicy::LRU;
+    std::string trace_name;
+    uint64_t working_set_kb = 0;
+    uint64_t stride_bytes = 0;
+    double miss_rate = 0.0;
+    double amat = 0.0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    bool classified = false;
+    MissClasses classes{};
+    PassCost cost;
+    bool cached = false;            // taken from the results cache
+};
+
+static ResultRow make_row(const PointSpec& p, const FunctionalResult& f, const PassCost& cost) {
+    ResultRow row;
+    row.experiment = p.experiment;
+    row.cache_kb = p.cache.cache_size / 1024;
+    row.line_size = p.cache.line_size;
+    row.assoc = p.cache.assoc;
+    row.hit_latency = p.timing.hit_latency;
+    row.miss_penalty = p.timing.miss_penalty;
+    row.pol = p.cache.policy;
+    row.trace_name = p.trace.name();
+    row.working_set_kb = p.working_set_kb;
+    row.stride_bytes = p.stride_bytes;
+    row.miss_rate = f.miss_rate();
+    row.amat = evaluate_timing(f, p.timing).amat;
+    row.hits = f.hits;
+    row.misses = f.misses;
+    row.classified = f.classified;
+    row.classes = f.classes;
+    row.cost = cost;
+    return row;
 }
 
-int main() {
-    // -----------------------------
-    // Baseline configuration
-    // -----------------------------
-    const size_t base_cache_kb   = 32;
-    const size_t base_line_size  = 64;
-    const size_t base_assoc      = 4;
-    const size_t base_hit_lat    = 1;
-    const size_t base_miss_pen   = 100;
-    const ReplacementPolicy base_policy = ReplacementPolicy::LRU;
-
-    // Trace knobs (kept stable)
-    const uint64_t stream_bytes   = 1ull << 20;  // 1MB
-    const uint64_t step_word      = 4;
-    const uint64_t reuse_passes   = 50;
-    const uint64_t conflict_acc   = 200000;
-    const uint64_t stride_acc     = 200000;
-
-    MemoryTiming mem;
-    mem.fixed_latency_cycles = 60;  // tune this
-    mem.bytes_per_cycle = 16;       // 16B/cycle
+static void write_row(std::ofstream& out, const ResultRow& r) {
+    out << r.experiment << ","
+        << r.cache_kb << ","
+        << r.line_size << ","
+        << r.assoc << ","
+        << r.hit_latency << ","
+        << r.miss_penalty << ","
+        << replacement_policy_name(r.pol) << ","
+        << r.trace_name << ","
+        << r.working_set_kb << ","
+        << r.stride_bytes << ",";
+    // A set-sampled point whose references all fell in unsampled sets has
+    // no estimate; leave its rates empty rather than print NaN or 0.
+    if (std::isnan(r.miss_rate)) {
+        out << ",,";
+    } else {
+        out << std::fixed << std::setprecision(6) << r.miss_rate << ","
+            << std::fixed << std::setprecision(3) << r.amat << ",";
+    }
+    out << r.hits << ","
+        << r.misses << ",";
+    // Miss classes are left empty for points that were not classified.
+    if (r.classified) {
+        out << r.classes.compulsory << "," << r.classes.capacity << "," << r.classes.conflict;
+    } else {
+        out << ",,";
+    }
 
-    std::ofstream out("results.csv");
-    out << "experiment,cache_kb,line_size,assoc,hit_latency,miss_penalty,policy,trace,working_set_kb,stride_bytes,miss_rate,amat,hits,misses\n";
+    // Simulator cost: wall time of the whole pass, then per simulated access.
+    const PassCost& c = r.cost;
+    const double sim_accesses = static_cast<double>(r.hits + r.misses) * static_cast<double>(c.configs);
+    out << "," << std::fixed << std::setprecision(3) << c.seconds * 1e3 << "," << c.configs << ",";
+    if (sim_accesses > 0 && c.seconds > 0) {
+        out << std::setprecision(3) << c.seconds * 1e9 / sim_accesses << ","
+            << std::setprecision(0) << sim_accesses / c.seconds;
+    } else {
+        out << ",";
+    }
+    out << ",";
+    // Each host column is left empty unless its event was measured.
+    const bool host = c.counted && sim_accesses > 0;
+    if (host && c.host.has_cycles) {
+        out << std::setprecision(3) << static_cast<double>(c.host.cycles) / sim_accesses;
+    }
+    out << ",";
+    if (host && c.host.has_instructions) {
+        out << std::setprecision(3) << static_cast<double>(c.host.instructions) / sim_accesses;
+    }
+    out << ",";
+    if (host && c.host.has_llc_misses) {
+        out << std::setprecision(5) << static_cast<double>(c.host.llc_misses) / sim_accesses;
+    }
+    out << "," << (r.cached ? 1 : 0) << "\n";
+}
 
-    // -----------------------------
-    // 0) Baseline run (reference point)
-    // -----------------------------
-    {
-        const uint64_t reuse_ws_kb = 24;
-        Cache c(base_cache_kb * 1024, base_line_size, base_assoc, base_hit_lat, base_miss_pen, base_policy);
-        c.reset_stats();
-        trace_reuse_working_set(c, reuse_ws_kb * 1024, step_word, reuse_passes);
+// -----------------------------
+// Sweep spec
+// -----------------------------
+//
+// A sweep is a list of experiments, read from a small INI-style file:
+//
+//   # comment
+//   [defaults]              values every experiment starts from
+//   key = value
+//
+//   [sweep_cache_size]      one experiment; the name is its `experiment` column
+//   cache_kb = 4 8 16 32    several values sweep the key
+//
+// An experiment with several swept keys runs their cartesian product, the
+// first swept key varying slowest; one with none is a single point.
+// Numeric values may name another key ("cache_kb") or add to it
+// ("assoc+1"), resolved per point. Keys:
+//
+//   cache_kb line_size assoc    geometry
+//   policy                      LRU FIFO RANDOM TREE_PLRU BIT_PLRU SRRIP BRRIP, or all
+//   hit_latency miss_penalty    cycles
+//   timing                      fixed, or memory (misses cost mem_latency plus
+//   mem_latency mem_bytes_per_cycle   the line transfer; miss_penalty is a label)
+//   trace                       stream   (bytes_kb, step)
+//                               reuse    (ws_kb, step, passes)
+//                               conflict (spacing_kb, hot_lines, accesses)
+//                               stride   (ws_kb, stride, accesses)
+//                               file     (path: a .cmt or .cmz trace)
+
+// The sweep run when no --spec is given; --dump-spec prints it as a
+// starting point for edits.
+static const char* const kDefaultSpec = R"(# Default run_experiments sweep.
+[defaults]
+cache_kb = 32
+line_size = 64
+assoc = 4
+policy = LRU
+hit_latency = 1
+miss_penalty = 100
+timing = fixed
+mem_latency = 60
+mem_bytes_per_cycle = 16
+trace = reuse
+ws_kb = 24
+step = 4
+passes = 50
+bytes_kb = 1024
+accesses = 200000
+
+# Reference point.
+[baseline]
+
+# Capacity effect on the reuse workload.
+[sweep_cache_size]
+cache_kb = 4 8 16 24 32 48 64 96 128
+
+# Conflict effect: one more hot line than there are ways.
+[sweep_associativity]
+assoc = 1 2 4 8 16
+trace = conflict
+spacing_kb = cache_kb
+hot_lines = assoc+1
+
+# Spatial locality on streaming.
+[sweep_line_size]
+line_size = 16 32 64 128 256
+timing = memory
+trace = stream
+
+[sweep_policy_conflict]
+policy = all
+trace = conflict
+spacing_kb = cache_kb
+hot_lines = assoc+1
+
+# Capacity curve: the cache stays fixed.
+[sweep_working_set]
+ws_kb = 4 8 12 16 20 24 28 32 40 48 64 96 128
+
+# Stride effects in a direct-mapped cache, working set = cache size.
+[sweep_stride]
+assoc = 1
+trace = stride
+ws_kb = 32
+stride = 4 8 16 32 64 128 256 512 1024 2048
+
+# Timing sensitivity: miss rates stay the same, AMAT moves.
+[sweep_miss_penalty]
+miss_penalty = 10 25 50 75 100 150 200 300
+
+[sweep_hit_latency]
+hit_latency = 1 2 3 4 5
 
-        write_row(out, "baseline",
-                  base_cache_kb, base_line_size, base_assoc, base_hit_lat, base_miss_pen,
-                  base_policy, "reuse_working_set",
-                  reuse_ws_kb, 0,
-                  c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+# Locality-heavy workload (LRU should look good here).
+[sweep_policy_locality]
+policy = all
+)";
+
+class SweepSpecParser {
+public:
+    // Throws std::runtime_error naming `origin` and the line on any error.
+    std::vector<PointSpec> parse(std::istream& in, const std::string& origin) {
+        this->origin = origin;
+        std::string text;
+        int line_no = 0;
+        Section* current = nullptr;
+        while (std::getline(in, text)) {
+            line_no++;
+            line = line_no;
+            const std::string s = trim(text.substr(0, text.find('#')));
+            if (s.empty()) continue;
+
+            if (s.front() == '[') {
+                if (s.back() != ']' || s.size() < 3) fail("malformed section header");
+                const std::string name = trim(s.substr(1, s.size() - 2));
+                if (name == "defaults") {
+                    current = &defaults;
+                } else {
+                    experiments.push_back(Section{name, line_no, {}});
+                    current = &experiments.back();
+                }
+                continue;
+            }
+
+            const size_t eq = s.find('=');
+            if (eq == std::string::npos) fail("expected key = value");
+            if (!current) fail("setting outside a section");
+            const std::string key = trim(s.substr(0, eq));
+            if (!known_key(key)) fail("unknown key '" + key + "'");
+            std::vector<std::string> values = split(s.substr(eq + 1));
+            if (values.empty()) fail("no value for '" + key + "'");
+            if (key == "policy" && values.size() == 1 && values[0] == "all") {
+                values.clear();
+                for (ReplacementPolicy p : kAllPolicies) values.push_back(replacement_policy_name(p));
+            }
+            if (current == &defaults && values.size() > 1) fail("defaults cannot sweep '" + key + "'");
+            current->entries.emplace_back(key, values);
+        }
+
+        std::vector<PointSpec> points;
+        for (const Section& e : experiments) expand(e, points);
+        return points;
     }
 
-    // -----------------------------
-    // 1) Sweep cache size (capacity effect) - reuse workload
-    // -----------------------------
-    {
-        const uint64_t reuse_ws_kb = 24;
-        for (size_t cache_kb : {4, 8, 16, 24, 32, 48, 64, 96, 128}) {
-            Cache c(cache_kb * 1024, base_line_size, base_assoc, base_hit_lat, base_miss_pen, base_policy);
-            c.reset_stats();
-            trace_reuse_working_set(c, reuse_ws_kb * 1024, step_word, reuse_passes);
-
-            write_row(out, "sweep_cache_size",
-                      cache_kb, base_line_size, base_assoc, base_hit_lat, base_miss_pen,
-                      base_policy, "reuse_working_set",
-                      reuse_ws_kb, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+private:
+    using Entry = std::pair<std::string, std::vector<std::string>>;
+    struct Section {
+        std::string name;
+        int line = 0;
+        std::vector<Entry> entries;
+    };
+    using Values = std::map<std::string, std::string>;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error(origin + ":" + std::to_string(line) + ": " + what);
+    }
+
+    static std::string trim(const std::string& s) {
+        const size_t b = s.find_first_not_of(" \t\r");
+        if (b == std::string::npos) return "";
+        return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+    }
+
+    static std::vector<std::string> split(const std::string& s) {
+        std::vector<std::string> out;
+        std::istringstream words(s);
+        std::string w;
+        while (words >> w) out.push_back(w);
+        return out;
+    }
+
+    static bool known_key(const std::string& k) {
+        static const char* const kKeys[] = {
+            "cache_kb", "line_size", "assoc", "policy", "hit_latency", "miss_penalty",
+            "timing", "mem_latency", "mem_bytes_per_cycle", "trace", "bytes_kb", "ws_kb",
+            "step", "passes", "spacing_kb", "hot_lines", "accesses", "stride", "path",
+        };
+        for (const char* known : kKeys) {
+            if (k == known) return true;
         }
+        return false;
     }
 
-    // -----------------------------
-    // 2) Sweep associativity (conflict effect)
-    // -----------------------------
-    {
-        for (size_t assoc : {1, 2, 4, 8, 16}) {
-            Cache c(base_cache_kb * 1024, base_line_size, assoc, base_hit_lat, base_miss_pen, base_policy);
-            c.reset_stats();
-
-            const uint64_t hot_lines = static_cast<uint64_t>(assoc) + 1;
-            trace_same_set_conflict(c, base_cache_kb * 1024, hot_lines, conflict_acc);
-
-            write_row(out, "sweep_associativity",
-                      base_cache_kb, base_line_size, assoc, base_hit_lat, base_miss_pen,
-                      base_policy, "same_set_conflict",
-                      0, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    void expand(const Section& e, std::vector<PointSpec>& points) {
+        line = e.line;
+        Values v;
+        for (const Entry& d : defaults.entries) v[d.first] = d.second.front();
+
+        // Later settings of a key replace earlier ones; swept keys keep the
+        // order of their first appearance.
+        std::vector<Entry> swept;
+        for (const Entry& s : e.entries) {
+            v[s.first] = s.second.front();
+            auto it = std::find_if(swept.begin(), swept.end(),
+                                   [&](const Entry& x) { return x.first == s.first; });
+            if (s.second.size() > 1) {
+                if (it == swept.end()) swept.push_back(s);
+                else it->second = s.second;
+            } else if (it != swept.end()) {
+                swept.erase(it);
+            }
         }
+        expand_from(e.name, swept, 0, v, points);
     }
 
-    // -----------------------------
-    // 3) Sweep line size (spatial locality on streaming)
-    // -----------------------------
-    {
-        for (size_t line_sz : {16, 32, 64, 128, 256}) {
-            Cache c(base_cache_kb * 1024, line_sz, base_assoc, base_hit_lat, mem, base_policy);
-            c.reset_stats();
-            trace_stream_sequential(c, stream_bytes, step_word);
-
-            write_row(out, "sweep_line_size",
-                      base_cache_kb, line_sz, base_assoc, base_hit_lat, base_miss_pen,
-                      base_policy, "stream_sequential",
-                      0, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    void expand_from(const std::string& name, const std::vector<Entry>& swept, size_t k,
+                     Values& v, std::vector<PointSpec>& points) {
+        if (k == swept.size()) {
+            points.push_back(make_point(name, v));
+            return;
+        }
+        for (const std::string& value : swept[k].second) {
+            v[swept[k].first] = value;
+            expand_from(name, swept, k + 1, v, points);
         }
     }
 
-    // -----------------------------
-    // 4) Sweep replacement policy (conflict-ish trace)
-    // -----------------------------
-    {
-        for (ReplacementPolicy pol : {ReplacementPolicy::LRU, ReplacementPolicy::FIFO, ReplacementPolicy::RANDOM}) {
-            Cache c(base_cache_kb * 1024, base_line_size, base_assoc, base_hit_lat, base_miss_pen, pol);
-            c.reset_stats();
-
-            const uint64_t hot_lines = static_cast<uint64_t>(base_assoc) + 1;
-            trace_same_set_conflict(c, base_cache_kb * 1024, hot_lines, conflict_acc);
-
-            write_row(out, "sweep_policy_conflict",
-                      base_cache_kb, base_line_size, base_assoc, base_hit_lat, base_miss_pen,
-                      pol, "same_set_conflict",
-                      0, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    std::string text(const Values& v, const std::string& key) const {
+        auto it = v.find(key);
+        if (it == v.end()) fail("experiment needs '" + key + "'");
+        return it->second;
+    }
+
+    // An integer, another key, or key+N.
+    uint64_t number(const Values& v, const std::string& key, int depth = 0) const {
+        if (depth > 8) fail("'" + key + "' refers to itself");
+        const std::string s = text(v, key);
+        if (std::isdigit(static_cast<unsigned char>(s[0]))) return parse_u64(s, key);
+        const size_t plus = s.find('+');
+        if (plus == std::string::npos) return number(v, s, depth + 1);
+        return number(v, s.substr(0, plus), depth + 1) + parse_u64(s.substr(plus + 1), key);
+    }
+
+    uint64_t parse_u64(const std::string& s, const std::string& key) const {
+        size_t used = 0;
+        uint64_t n = 0;
+        try {
+            n = std::stoull(s, &used);
+        } catch (const std::exception&) {
+            used = 0;
         }
+        if (used != s.size()) fail("'" + key + "' is not a number: " + s);
+        return n;
     }
 
-    // -----------------------------
-    // 5) Sweep working set size (capacity curve)
-    // Keep cache fixed; change only working set.
-    // -----------------------------
-    {
-        for (uint64_t ws_kb : {4, 8, 12, 16, 20, 24, 28, 32, 40, 48, 64, 96, 128}) {
-            Cache c(base_cache_kb * 1024, base_line_size, base_assoc, base_hit_lat, base_miss_pen, base_policy);
-            c.reset_stats();
-            trace_reuse_working_set(c, ws_kb * 1024, step_word, reuse_passes);
-
-            write_row(out, "sweep_working_set",
-                      base_cache_kb, base_line_size, base_assoc, base_hit_lat, base_miss_pen,
-                      base_policy, "reuse_working_set",
-                      ws_kb, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    PointSpec make_point(const std::string& name, const Values& v) const {
+        PointSpec p;
+        p.experiment = name;
+
+        const std::string policy = text(v, "policy");
+        bool found = false;
+        for (ReplacementPolicy pol : kAllPolicies) {
+            if (policy == replacement_policy_name(pol)) {
+                p.cache.policy = pol;
+                found = true;
+            }
         }
+        if (!found) fail("unknown policy '" + policy + "'");
+        p.cache.cache_size = static_cast<size_t>(number(v, "cache_kb")) * 1024;
+        p.cache.line_size = static_cast<size_t>(number(v, "line_size"));
+        p.cache.assoc = static_cast<size_t>(number(v, "assoc"));
+
+        const size_t hit = static_cast<size_t>(number(v, "hit_latency"));
+        const size_t penalty = static_cast<size_t>(number(v, "miss_penalty"));
+        const std::string timing = text(v, "timing");
+        if (timing == "fixed") {
+            p.timing = fixed_timing(hit, penalty);
+        } else if (timing == "memory") {
+            MemoryTiming mem;
+            mem.fixed_latency_cycles = static_cast<size_t>(number(v, "mem_latency"));
+            mem.bytes_per_cycle = static_cast<size_t>(number(v, "mem_bytes_per_cycle"));
+            p.timing = memory_timing(hit, penalty, mem);
+        } else {
+            fail("unknown timing '" + timing + "'");
+        }
+
+        const std::string trace = text(v, "trace");
+        if (trace == "stream") {
+            p.trace = stream_trace(number(v, "bytes_kb") * 1024, number(v, "step"));
+        } else if (trace == "reuse") {
+            p.working_set_kb = number(v, "ws_kb");
+            p.trace = reuse_trace(p.working_set_kb * 1024, number(v, "step"), number(v, "passes"));
+        } else if (trace == "conflict") {
+            p.trace = conflict_trace(number(v, "spacing_kb") * 1024, number(v, "hot_lines"), number(v, "accesses"));
+        } else if (trace == "stride") {
+            p.working_set_kb = number(v, "ws_kb");
+            p.stride_bytes = number(v, "stride");
+            p.trace = stride_trace(p.working_set_kb * 1024, p.stride_bytes, number(v, "accesses"));
+        } else if (trace == "file") {
+            p.trace = file_trace(text(v, "path"));
+        } else {
+            fail("unknown trace '" + trace + "'");
+        }
+        return p;
     }
 
-    // -----------------------------
-    // 6) Sweep stride (stride effects within a fixed working set)
-    // Keep cache + WS fixed; change only stride.
-    // -----------------------------
-    {
-        const uint64_t ws_kb = 32; // same as cache size for interesting behavior
-        for (uint64_t stride : {4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048}) {
-            Cache c(base_cache_kb * 1024, base_line_size, 1 /*direct-mapped*/, base_hit_lat, base_miss_pen, base_policy);
-            c.reset_stats();
-            trace_stride(c, ws_kb * 1024, stride, stride_acc);
-
-            write_row(out, "sweep_stride",
-                      base_cache_kb, base_line_size, 1, base_hit_lat, base_miss_pen,
-                      base_policy, "stride_walk",
-                      ws_kb, stride,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    std::string origin;
+    int line = 0;
+    Section defaults;
+    std::vector<Section> experiments;
+};
+
+// -----------------------------
+// Sweep driver
+// -----------------------------
+
+// A task fills the rows of the points it covers; tasks touch disjoint rows.
+using SweepTask = std::function<void()>;
+
+// Caches a sweep worker has finished with. A task reconfigures one of the
+// same policy rather than constructing a cache, so once every worker has
+// seen the largest geometry a sweep no longer goes to the allocator for
+// tag stores or replacement state. One pool per worker thread, so tasks
+// never contend for it.
+class CachePool {
+public:
+    Cache acquire(const PointSpec& p, size_t set_sample, bool classify) {
+        const CacheGeometry& g = p.cache;
+        auto it = std::find_if(spare.begin(), spare.end(),
+                               [&](const Cache& c) { return c.policy() == g.policy; });
+        if (it == spare.end()) {
+            Cache c(g.cache_size, g.line_size, g.assoc, p.timing, g.policy);
+            prepare(c, set_sample, classify);
+            return c;
         }
+        Cache c = std::move(*it);
+        spare.erase(it);
+        c.reconfigure(g.cache_size, g.line_size, g.assoc, p.timing, g.policy);
+        prepare(c, set_sample, classify);
+        return c;
     }
 
-    // -----------------------------
-    // 7) Sweep miss penalty (timing sensitivity)
-    // Miss rate stays same; AMAT changes.
-    // -----------------------------
-    {
-        const uint64_t reuse_ws_kb = 24;
-        for (size_t mp : {10, 25, 50, 75, 100, 150, 200, 300}) {
-            Cache c(base_cache_kb * 1024, base_line_size, base_assoc, base_hit_lat, mp, base_policy);
-            c.reset_stats();
-            trace_reuse_working_set(c, reuse_ws_kb * 1024, step_word, reuse_passes);
-
-            write_row(out, "sweep_miss_penalty",
-                      base_cache_kb, base_line_size, base_assoc, base_hit_lat, mp,
-                      base_policy, "reuse_working_set",
-                      reuse_ws_kb, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    void release(Cache c) { spare.push_back(std::move(c)); }
+
+    static CachePool& local() {
+        thread_local CachePool pool;
+        return pool;
+    }
+
+private:
+    // A reconfigured cache keeps its classification, so switch it off too.
+    static void prepare(Cache& c, size_t set_sample, bool classify) {
+        if (set_sample > 1) {
+            c.disable_miss_classification();
+            c.enable_set_sampling(set_sample);
+        } else if (classify) {
+            c.enable_miss_classification();
+        } else {
+            c.disable_miss_classification();
+        }
+    }
+
+    std::vector<Cache> spare;
+};
+
+// Turns points into the fewest functional passes:
+//  - points are grouped by trace, then by cache geometry. Within a geometry
+//    group only timing differs, so one functional pass is re-timed for
+//    every point (timing-only axes such as miss penalty and hit latency);
+//  - LRU geometries of one trace group that share a line size are answered
+//    together from a single stack-distance pass;
+//  - the remaining geometries of a trace group share one trace pass through
+//    a MultiCacheDriver, so the trace is generated or decoded only once.
+struct SweepOptions {
+    // > 1 makes replayed caches simulate about one set in that many
+    // (Cache::enable_set_sampling); stack-distance groups stay exact.
+    size_t set_sample = 1;
+    // Read host perf_event counters around every pass.
+    bool host_counters = false;
+    // Generate or read each pass's trace on a separate thread
+    // (PrefetchingTraceSource).
+    bool prefetch = false;
+    // Split misses into compulsory/capacity/conflict. Off by default: the
+    // shadow cache it runs costs every replayed reference, and sweep timings
+    // should measure the cache alone.
+    bool classify = false;
+};
+
+// Every pass is timed on the worker that runs it (PassCost).
+// Points marked `skip` (already answered) get no pass.
+static std::vector<SweepTask> plan_tasks(const std::vector<PointSpec>& points, std::vector<ResultRow>& rows,
+                                         const SweepOptions& opts, const std::vector<bool>& skip) {
+    // trace key -> geometry key -> point indices
+    std::map<std::string, std::map<std::string, std::vector<size_t>>> groups;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (skip[i]) continue;
+        groups[points[i].trace.key()][points[i].cache.key()].push_back(i);
+    }
+
+    auto emit = [&points, &rows](const std::vector<size_t>& indices, const FunctionalResult& f,
+                                 const PassCost& cost) {
+        for (size_t i : indices) rows[i] = make_row(points[i], f, cost);
+    };
+
+    std::vector<SweepTask> tasks;
+    for (const auto& trace_group : groups) {
+        // line size -> LRU geometry groups
+        std::map<size_t, std::vector<std::vector<size_t>>> lru_by_line;
+        std::vector<std::vector<size_t>> replays;
+
+        for (const auto& geom_group : trace_group.second) {
+            const CacheGeometry& g = points[geom_group.second.front()].cache;
+            if (g.policy == ReplacementPolicy::LRU) lru_by_line[g.line_size].push_back(geom_group.second);
+            else replays.push_back(geom_group.second);
+        }
+
+        for (const auto& line_group : lru_by_line) {
+            if (line_group.second.size() < 2) {
+                replays.push_back(line_group.second.front());
+                continue;
+            }
+
+            const std::vector<std::vector<size_t>> members = line_group.second;
+            tasks.push_back([&points, emit, members, opts] {
+                const TraceSpec& trace = points[members.front().front()].trace;
+                const size_t line_size = points[members.front().front()].cache.line_size;
+
+                // One extra fully-associative geometry (a single set) gives
+                // the 3C split of every member: its misses at the member's
+                // capacity versus cold misses and the member's own misses.
+                std::vector<size_t> set_counts;
+                size_t max_assoc = 1;
+                for (const auto& m : members) {
+                    const CacheGeometry& g = points[m.front()].cache;
+                    set_counts.push_back(g.num_sets());
+                    // The fully-associative curve must reach the whole capacity.
+                    max_assoc = std::max(max_assoc, opts.classify ? g.num_sets() * g.assoc : g.assoc);
+                }
+                if (opts.classify) set_counts.push_back(1);  // fully-associative reference
+
+                StackDistanceAnalyzer sd(line_size, set_counts, max_assoc);
+                const PassCost cost = measure_pass(opts.host_counters, members.size(),
+                                                   [&] { run_trace(trace, sd, opts.prefetch); });
+                const std::vector<MissRatioCurve> curves = sd.curves();
+
+                for (size_t k = 0; k < members.size(); k++) {
+                    const CacheGeometry& g = points[members[k].front()].cache;
+                    FunctionalResult f;
+                    f.line_size = line_size;
+                    f.hits = curves[k].hits(g.assoc);
+                    f.misses = curves[k].misses(g.assoc);
+                    if (opts.classify) {
+                        const MissRatioCurve& fa = curves.back();
+                        const uint64_t fa_misses = fa.misses(g.num_sets() * g.assoc);
+                        f.classified = true;
+                        f.classes.compulsory = fa.cold_misses;
+                        f.classes.capacity = fa_misses - fa.cold_misses;
+                        f.classes.conflict = static_cast<int64_t>(f.misses) - static_cast<int64_t>(fa_misses);
+                    }
+                    emit(members[k], f, cost);
+                }
+            });
+        }
+
+        if (replays.size() == 1) {
+            const std::vector<size_t> indices = replays.front();
+            tasks.push_back([&points, emit, indices, opts] {
+                const PointSpec& p = points[indices.front()];
+                CachePool& pool = CachePool::local();
+                Cache c = pool.acquire(p, opts.set_sample, opts.classify);
+                // Policy dispatch happens here, once: the trace loop below is
+                // instantiated for the concrete BasicCache.
+                const PassCost cost = measure_pass(opts.host_counters, 1, [&] {
+                    c.visit([&](auto& impl) { run_trace(p.trace, impl, opts.prefetch); });
+                });
+                emit(indices, c.functional_result(), cost);
+                pool.release(std::move(c));
+            });
+        } else if (replays.size() > 1) {
+            tasks.push_back([&points, emit, replays, opts] {
+                CachePool& pool = CachePool::local();
+                MultiCacheDriver driver;
+                for (const auto& indices : replays) {
+                    driver.add(pool.acquire(points[indices.front()], opts.set_sample, opts.classify));
+                }
+                const PassCost cost = measure_pass(opts.host_counters, replays.size(), [&] {
+                    run_trace(points[replays.front().front()].trace, driver, opts.prefetch);
+                });
+                for (size_t k = 0; k < replays.size(); k++) {
+                    emit(replays[k], driver.at(k).functional_result(), cost);
+                }
+                for (Cache& c : driver.release()) pool.release(std::move(c));
+            });
+        }
+    }
+    return tasks;
+}
+
+// -----------------------------
+// Results cache
+// -----------------------------
+
+// Functional results of earlier runs, on disk, so a re-run only simulates
+// points it has not seen. A point's key is its cache geometry and policy,
+// its trace (for trace files also their size and modification time) and
+// the simulation options that change hit/miss counts. Timing is not part
+// of it: hit/miss behavior never depends on latencies, and a cached result
+// is re-timed for the point's own TimingParams (make_row), so timing-only
+// sweeps hit the cache too. Entries are stored with a 64-bit FNV-1a hash
+// of the key and the key itself, one tab-separated line each; the pass
+// cost recorded is that of the run that simulated the point. The header
+// carries a model version, so results from an older simulator are dropped.
+class ResultCache {
+public:
+    // Version of the simulation semantics the stored counts came from.
+    // Bump it with any change that can alter a point's hit/miss counts
+    // (cache or policy behavior, trace generators, the default seeds): a
+    // file written under another version is discarded as a whole rather
+    // than served as stale results.
+    static constexpr int kModelVersion = 1;
+    // Version of the line layout below.
+    static constexpr int kFormatVersion = 2;
+
+    // The only place either version reaches the file.
+    static std::string header() {
+        return "# run_experiments results cache v" + std::to_string(kFormatVersion) +
+               " model " + std::to_string(kModelVersion);
+    }
+
+    // Loads `path` if it exists; unreadable lines are skipped.
+    explicit ResultCache(std::string path) : path(std::move(path)) {
+        std::ifstream in(this->path);
+        std::string line;
+        if (!std::getline(in, line) || line != header()) return;
+        while (std::getline(in, line)) {
+            std::istringstream f(line);
+            std::string hash, key;
+            Entry e;
+            int estimable = 0, classified = 0;
+            if (!std::getline(f, hash, '\t') || !std::getline(f, key, '\t')) continue;
+            if (!(f >> e.result.line_size >> e.result.hits >> e.result.misses >> estimable >> classified >>
+                  e.result.classes.compulsory >> e.result.classes.capacity >> e.result.classes.conflict >>
+                  e.cost.seconds >> e.cost.configs)) {
+                continue;
+            }
+            if (hash != hash_hex(key)) continue;
+            e.result.estimable = estimable != 0;
+            e.result.classified = classified != 0;
+            entries[key] = e;
         }
     }
 
+    bool find(const std::string& key, FunctionalResult& result, PassCost& cost) const {
+        auto it = entries.find(key);
+        if (it == entries.end()) return false;
+        result = it->second.result;
+        cost = it->second.cost;
+        return true;
+    }
+
+    void put(const std::string& key, const FunctionalResult& result, const PassCost& cost) {
+        Entry& e = entries[key];
+        e.result = result;
+        e.cost = cost;
+        e.cost.counted = false;     // host counters are not kept
+    }
+
+    // Rewrites the file through a temporary, so an interrupted run leaves
+    // the previous cache intact. Throws std::runtime_error on failure.
+    void save() const {
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp);
+            out << header() << "\n";
+            for (const auto& kv : entries) {
+                const Entry& e = kv.second;
+                out << hash_hex(kv.first) << "\t" << kv.first << "\t"
+                    << e.result.line_size << " " << e.result.hits << " " << e.result.misses << " "
+                    << (e.result.estimable ? 1 : 0) << " " << (e.result.classified ? 1 : 0) << " " << e.result.classes.compulsory << " "
+                    << e.result.classes.capacity << " " << e.result.classes.conflict << " "
+                    << std::setprecision(17) << e.cost.seconds << " " << e.cost.configs << "\n";
+            }
+            if (!out.flush()) throw std::runtime_error("cannot write results cache: " + tmp);
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("cannot replace results cache: " + path);
+        }
+    }
+
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        FunctionalResult result;
+        PassCost cost;
+    };
+
+    static std::string hash_hex(const std::string& key) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (unsigned char c : key) h = (h ^ c) * 0x100000001b3ULL;
+        std::ostringstream s;
+        s << std::hex << std::setw(16) << std::setfill('0') << h;
+        return s.str();
+    }
+
+    std::string path;
+    std::map<std::string, Entry> entries;
+};
+
+// Cache key of a point (see ResultCache).
+static std::string result_key(const PointSpec& p, const SweepOptions& opts) {
+    std::string key = "geometry=" + p.cache.key() + "|trace=" + p.trace.key();
+    if (p.trace.kind == TraceKind::File) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(p.trace.path, ec);
+        const auto mtime = std::filesystem::last_write_time(p.trace.path, ec);
+        key += "|file=" + std::to_string(ec ? 0 : size) + ":" +
+               std::to_string(ec ? 0 : mtime.time_since_epoch().count());
+    }
+    key += "|set_sample=" + std::to_string(opts.set_sample);
+    key += opts.classify ? "|classes=1" : "|classes=0";
+    return key;
+}
+
+// Value following `flag` on the command line, or "" if absent.
+static std::string parse_option(int argc, char** argv, const std::string& flag) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (flag == argv[i]) return argv[i + 1];
+    }
+    return "";
+}
+
+static bool has_flag(int argc, char** argv, const std::string& flag) {
+    for (int i = 1; i < argc; i++) {
+        if (flag == argv[i]) return true;
+    }
+    return false;
+}
+
+// Whole-number value of `flag`, or `fallback` if absent. Throws
+// std::runtime_error unless the value is a number of at least `min`.
+static size_t parse_count_option(int argc, char** argv, const std::string& flag,
+                                 size_t fallback, size_t min) {
+    const std::string s = parse_option(argc, argv, flag);
+    if (s.empty()) return fallback;
+    size_t used = 0;
+    unsigned long long n = 0;
+    try {
+        if (!std::isdigit(static_cast<unsigned char>(s[0]))) throw std::invalid_argument(s);
+        n = std::stoull(s, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != s.size()) throw std::runtime_error(flag + " expects a number, got '" + s + "'");
+    if (n < min) throw std::runtime_error(flag + " must be at least " + std::to_string(min));
+    return static_cast<size_t>(n);
+}
+
+int main(int argc, char** argv) {
+    if (has_flag(argc, argv, "--dump-spec")) {
+        std::cout << kDefaultSpec;
+        return 0;
+    }
+
     // -----------------------------
-    // 8) Sweep hit latency (timing sensitivity)
-    // Miss rate stays same; AMAT shifts by constant.
+    // Sweep points (--spec FILE, or the built-in sweep) and options
     // -----------------------------
-    {
-        const uint64_t reuse_ws_kb = 24;
-        for (size_t hl : {1, 2, 3, 4, 5}) {
-            Cache c(base_cache_kb * 1024, base_line_size, base_assoc, hl, base_miss_pen, base_policy);
-            c.reset_stats();
-            trace_reuse_working_set(c, reuse_ws_kb * 1024, step_word, reuse_passes);
-
-            write_row(out, "sweep_hit_latency",
-                      base_cache_kb, base_line_size, base_assoc, hl, base_miss_pen,
-                      base_policy, "reuse_working_set",
-                      reuse_ws_kb, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    std::vector<PointSpec> points;
+    size_t threads = 0;             // 0: one per hardware thread
+    SweepOptions opts;
+    try {
+        const std::string spec_path = parse_option(argc, argv, "--spec");
+        std::stringstream spec;
+        if (spec_path.empty()) {
+            spec << kDefaultSpec;
+        } else {
+            std::ifstream in(spec_path);
+            if (!in) throw std::runtime_error("cannot open sweep spec: " + spec_path);
+            spec << in.rdbuf();
+        }
+
+        // Replay a captured trace file (--trace path.cmt|.cmz) on the defaults.
+        const std::string trace_path = parse_option(argc, argv, "--trace");
+        if (!trace_path.empty()) spec << "\n[trace_replay]\ntrace = file\npath = " << trace_path << "\n";
+
+        points = SweepSpecParser().parse(spec, spec_path.empty() ? "built-in spec" : spec_path);
+
+        threads = parse_count_option(argc, argv, "--threads", 0, 0);
+        opts.set_sample = parse_count_option(argc, argv, "--set-sample", 1, 1);
+        opts.classify = has_flag(argc, argv, "--classify");
+#ifndef CACHE_MODEL_MISS_CLASSES
+        if (opts.classify) {
+            throw std::runtime_error("--classify needs the library built with CACHE_MODEL_MISS_CLASSES");
         }
+#endif
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
     }
 
     // -----------------------------
-    // 9) Policy sweep on locality-heavy workload (LRU should look good here)
+    // Plan and run, then write in order
     // -----------------------------
-    {
-        const uint64_t reuse_ws_kb = 24;
-        for (ReplacementPolicy pol : {ReplacementPolicy::LRU, ReplacementPolicy::FIFO, ReplacementPolicy::RANDOM}) {
-            Cache c(base_cache_kb * 1024, base_line_size, base_assoc, base_hit_lat, base_miss_pen, pol);
-            c.reset_stats();
-            trace_reuse_working_set(c, reuse_ws_kb * 1024, step_word, reuse_passes);
-
-            write_row(out, "sweep_policy_locality",
-                      base_cache_kb, base_line_size, base_assoc, base_hit_lat, base_miss_pen,
-                      pol, "reuse_working_set",
-                      reuse_ws_kb, 0,
-                      c.get_miss_rate(), c.get_amat(), c.get_hits(), c.get_misses());
+    std::vector<ResultRow> rows(points.size());
+    opts.host_counters = has_flag(argc, argv, "--perf");
+    opts.prefetch = has_flag(argc, argv, "--prefetch");
+    if (opts.host_counters && !HostCounters().valid()) {
+        std::cerr << "warning: perf_event counters unavailable; host counter columns left empty\n";
+    }
+
+    // Points already in the results cache are only re-timed.
+    const bool use_cache = !has_flag(argc, argv, "--no-cache");
+    const std::string cache_arg = parse_option(argc, argv, "--cache");
+    ResultCache cache(cache_arg.empty() ? "results_cache.tsv" : cache_arg);
+    std::vector<std::string> keys(points.size());
+    std::vector<bool> cached(points.size(), false);
+    size_t num_cached = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!use_cache) break;
+        keys[i] = result_key(points[i], opts);
+        FunctionalResult f;
+        PassCost cost;
+        if (cache.find(keys[i], f, cost)) {
+            rows[i] = make_row(points[i], f, cost);
+            rows[i].cached = true;
+            cached[i] = true;
+            num_cached++;
+        }
+    }
+    const std::vector<SweepTask> tasks = plan_tasks(points, rows, opts, cached);
+
+    ThreadPool pool(threads);
+    pool.parallel_for(tasks.size(), [&](size_t i) { tasks[i](); });
+
+    if (use_cache && num_cached < points.size()) {
+        for (size_t i = 0; i < points.size(); i++) {
+            if (cached[i]) continue;
+            const ResultRow& r = rows[i];
+            FunctionalResult f;
+            f.line_size = r.line_size;
+            f.hits = r.hits;
+            f.misses = r.misses;
+            f.estimable = !std::isnan(r.miss_rate);
+            f.classified = r.classified;
+            f.classes = r.classes;
+            cache.put(keys[i], f, r.cost);
+        }
+        try {
+            cache.save();
+        } catch (const std::exception& e) {
+            std::cerr << "warning: " << e.what() << "\n";
         }
     }
 
-    std::cout << "Wrote results.csv\n";
+    std::ofstream out("results.csv");
+    out << "experiment,cache_kb,line_size,assoc,hit_latency,miss_penalty,policy,trace,working_set_kb,stride_bytes,miss_rate,amat,hits,misses,compulsory_misses,capacity_misses,conflict_misses,"
+           "sim_ms,pass_configs,ns_per_access,accesses_per_sec,"
+           "host_cycles_per_access,host_instructions_per_access,host_llc_misses_per_access,cached\n";
+    for (const auto& row : rows) write_row(out, row);
+
+    std::cout << "Wrote results.csv (" << rows.size() << " points, " << num_cached << " from cache, "
+              << tasks.size() << " simulation passes, " << pool.size() << " threads)\n";
     return 0;
 }
@@ -0,0 +1,126 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// C interface to the cache model, for foreign-function callers (the Python
+// bindings in python/cache_model.py load it with ctypes). Built as the
+// shared library cache_model_c.
+//
+// Every call that can fail returns a cm_status and leaves the reason in
+// cm_last_error(), which is per thread. Handles are owned by the caller and
+// released with the matching _free call. Arrays are read and written in
+// place, never copied, so bulk calls cost what the C++ calls cost. No call
+// takes a lock: a handle must not be used from two threads at once, but
+// distinct handles may run concurrently.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CM_OK = 0,
+    CM_INVALID_ARGUMENT = 1,    // std::invalid_argument / std::out_of_range
+    CM_ERROR = 2                // anything else
+} cm_status;
+
+typedef struct cm_cache cm_cache;
+typedef struct cm_stack_distance cm_stack_distance;
+typedef struct cm_intervals cm_intervals;
+
+// Mirrors BatchStats.
+typedef struct {
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t skipped;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t total_latency;
+} cm_batch_stats;
+
+// Running totals of a cache; the miss classes are zero unless
+// classification is enabled.
+typedef struct {
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t compulsory;
+    uint64_t capacity;
+    int64_t  conflict;
+    double   miss_rate;
+    double   amat;
+} cm_cache_stats;
+
+// Scalars of one MissRatioCurve.
+typedef struct {
+    uint64_t line_size;
+    uint64_t num_sets;
+    uint64_t accesses;
+    uint64_t cold_misses;
+    uint64_t beyond;
+    uint64_t max_assoc;
+} cm_curve_info;
+
+// Message of the last failed call on this thread; "" if none.
+const char* cm_last_error(void);
+
+// policy is a ReplacementPolicy value (0 = LRU ... 6 = BRRIP).
+const char* cm_policy_name(int policy);
+
+// ---- Cache ----
+
+cm_status cm_cache_new(uint64_t cache_size, uint64_t line_size, uint64_t associativity,
+                       uint64_t hit_latency, uint64_t miss_penalty, int policy,
+                       cm_cache** out);
+void cm_cache_free(cm_cache* cache);
+
+// Cache::access_batch over `count` addresses. is_write (one byte per
+// reference), hits (one byte per reference, 1 = hit) and latencies (one
+// u64 per reference) may each be null; stats may be null.
+cm_status cm_cache_access_batch(cm_cache* cache, const uint64_t* addresses, size_t count,
+                                const uint8_t* is_write, uint8_t* hits, uint64_t* latencies,
+                                cm_batch_stats* stats);
+// Cache::warm: installs the lines, counting nothing.
+cm_status cm_cache_warm(cm_cache* cache, const uint64_t* addresses, size_t count);
+
+cm_status cm_cache_stats_get(const cm_cache* cache, cm_cache_stats* out);
+cm_status cm_cache_num_sets(const cm_cache* cache, uint64_t* out);
+cm_status cm_cache_reset_stats(cm_cache* cache);
+cm_status cm_cache_flush(cm_cache* cache);
+cm_status cm_cache_enable_miss_classification(cm_cache* cache, unsigned seen_bits);
+cm_status cm_cache_enable_set_sampling(cm_cache* cache, uint64_t ratio, uint64_t seed);
+cm_status cm_cache_save_checkpoint(const cm_cache* cache, const char* path);
+cm_status cm_cache_restore_checkpoint(cm_cache* cache, const char* path);
+
+// ---- Stack-distance analysis ----
+
+cm_status cm_sd_new(uint64_t line_size, const uint64_t* set_counts, size_t set_count_len,
+                    uint64_t max_assoc, cm_stack_distance** out);
+void cm_sd_free(cm_stack_distance* sd);
+
+cm_status cm_sd_access_batch(cm_stack_distance* sd, const uint64_t* addresses, size_t count);
+
+// Curves are in constructor order. cm_sd_curve_info fills the scalars;
+// cm_sd_curve_misses writes misses(a) for a = 1 .. max_assoc into `out`
+// (max_assoc entries); cm_sd_curve_distances writes distance_counts.
+cm_status cm_sd_curve_info(const cm_stack_distance* sd, size_t curve, cm_curve_info* out);
+cm_status cm_sd_curve_misses(const cm_stack_distance* sd, size_t curve, uint64_t* out, size_t len);
+cm_status cm_sd_curve_distances(const cm_stack_distance* sd, size_t curve, uint64_t* out, size_t len);
+
+// ---- Time series ----
+
+// An IntervalStatsCollector on `cache`, which must outlive it.
+cm_status cm_intervals_new(cm_cache* cache, uint64_t interval, cm_intervals** out);
+void cm_intervals_free(cm_intervals* iv);
+
+cm_status cm_intervals_access_batch(cm_intervals* iv, const uint64_t* addresses, size_t count,
+                                    const uint8_t* is_write);
+cm_status cm_intervals_finish(cm_intervals* iv);
+cm_status cm_intervals_count(const cm_intervals* iv, size_t* out);
+// Writes `rows` intervals from the history, six u64 each: index, start,
+// accesses, hits, misses, total_latency.
+cm_status cm_intervals_copy(const cm_intervals* iv, uint64_t* out, size_t rows);
+
+#ifdef __cplusplus
+}
+#endif
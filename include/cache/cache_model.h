@@ -2,35 +2,155 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <variant>
 #include <vector>
 #include <iostream>
+#include <optional>
 
+#include "cache/fast_div.h"
+#include "cache/line_index.h"
+#include "cache/miss_classifier.h"
 #include "cache/replacement_policy.h"
+#include "cache/storage.h"
+#include "cache/tag_match.h"
+#include "cache/timing.h"
 #include "cache/types.h"
 
-class Cache {
+class CacheSnapshot;
+class ThreadPool;
+
+// Set-associative cache with the replacement policy fixed at compile time.
+// `Policy` is one of the state classes in replacement_policy.h; hits and
+// fills call straight into it, so a policy that keeps no state on hits
+// (FIFO, RANDOM) costs nothing there. Instantiated for every policy in
+// cache_model.cpp; use Cache to pick the policy at run time.
+template <typename Policy>
+class BasicCache final : public IStorage {
 public:
-    Cache(size_t cache_size,
-          size_t line_size,
-          size_t associativity,
-          size_t hit_latency,
-          size_t miss_penalty,
-          ReplacementPolicy policy = ReplacementPolicy::LRU);
-        
-    //New Constructor for realistic miss penalty
-    Cache(size_t cache_size,
-          size_t line_size,
-          size_t associativity,
-          size_t hit_latency,
-          MemoryTiming mem_timing,
-          ReplacementPolicy policy = ReplacementPolicy::LRU);
+    BasicCache(size_t cache_size,
+               size_t line_size,
+               size_t associativity,
+               TimingParams timing);
+
+    // Turns this cache into a new, empty one with the given geometry and
+    // timing, as if freshly constructed, but reusing the tag store and the
+    // replacement and classification buffers whenever they are large
+    // enough, so a worker sweeping many configurations does not go back
+    // to the allocator for each one. Stats reset and set sampling turns
+    // off; the next-level link and miss classification (re-sized) carry
+    // over. Throws like the constructor and leaves the cache unchanged if
+    // the geometry is invalid.
+    void reconfigure(size_t cache_size,
+                     size_t line_size,
+                     size_t associativity,
+                     TimingParams timing);
+
+    // On a miss the latency is hit_latency plus either the fixed/memory
+    // miss penalty or, when a next level is linked, that level's latency.
+    bool access(uint64_t address, uint64_t& latency) override;
+
+    // Lookup + fill with stats but no timing; used by CacheHierarchy, which
+    // composes latencies itself.
+    bool lookup(uint64_t address);
+
+    // Functional warming: updates tags and replacement state exactly as
+    // access_batch would, but counts nothing, computes no latency and never
+    // touches a next level. Used between measurement windows when sampling.
+    void warm(const uint64_t* addresses, size_t count);
 
-    bool access(uint64_t address, uint64_t& latency);
+    // Runtime-composed hierarchies: forward misses to `next` (not owned).
+    // Null restores the fixed/memory miss penalty.
+    void set_next_level(IStorage* next) { next_level = next; }
+    IStorage* get_next_level() const { return next_level; }
+
+    // Simulates `count` references from a contiguous address array in order.
+    // `is_write` (nonzero = write) and `results` are optional; when given they
+    // must hold `count` entries. Equivalent to calling access() per address.
+    BatchStats access_batch(const uint64_t* addresses,
+                            size_t count,
+                            const uint8_t* is_write = nullptr,
+                            AccessResult* results = nullptr);
+
+    // Simulates the same references as access_batch, in parallel on `pool`.
+    // The trace is split by set index into one contiguous set range per
+    // worker; each set still sees its own references in trace order, so LRU
+    // and FIFO results match the serial path exactly. RANDOM draws from
+    // per-set streams derived from rng_state, which keeps results independent
+    // of the thread count (but not identical to the serial path). The trace
+    // is bucketed a bounded chunk at a time, never copied whole. Throws
+    // std::logic_error if a next level is linked, since the workers would
+    // race on it.
+    BatchStats access_partitioned(const uint64_t* addresses,
+                                  size_t count,
+                                  ThreadPool& pool);
 
     void print_stats() const;
 
     // --- Stats control ---
-    void reset_stats();
+    // Zeroes the counters only; cache contents and replacement state stay
+    // warm, so a warmup phase can be followed by a measured one.
+    void reset_stats() override;
+
+    // Invalidates every line in O(1): sets (and the miss classifier's
+    // state) are cleared lazily on their next reference. Counters are left
+    // alone.
+    void flush();
+
+    // --- Set sampling ---
+    // Simulates only about one set in `ratio`, chosen by hashing the set
+    // index with `seed`; references to other sets are dropped before the
+    // tag lookup (access()/lookup() report them as misses with latency 0,
+    // and they are never forwarded to a next level). The getters, the
+    // functional result and AMAT then extrapolate to the full cache.
+    // A trace that touches fewer than about num_sets / ratio sets may miss
+    // every sampled set; it is then not estimable, and the miss rate, AMAT
+    // and CI come out NaN / infinite (FunctionalResult::estimable).
+    // ratio == 1 turns sampling off. Either call resets stats and flushes.
+    void enable_set_sampling(size_t ratio, uint64_t seed = 0);
+    void disable_set_sampling() { enable_set_sampling(1); }
+    bool set_sampling_enabled() const { return !sample_counts.empty(); }
+
+    // Miss-rate estimate with a confidence interval at `z` standard errors
+    // (1.96 = 95%). Exact, with a zero-width interval, when not sampling.
+    SetSampleEstimate set_sample_estimate(double z = 1.96) const;
+    double get_miss_rate_ci(double z = 1.96) const { return set_sample_estimate(z).ci_half_width; }
+
+    // --- Miss classification ---
+    // Splits misses into compulsory / capacity / conflict (MissClasses) by
+    // feeding every reference, warm() included, to a MissClassifier. While
+    // enabled each reference pays a bitmap probe and a shadow-cache lookup;
+    // disabled it costs one predictable branch, and builds without
+    // CACHE_MODEL_MISS_CLASSES drop the hook altogether (enabling then
+    // throws std::logic_error). Incompatible with set sampling, since the
+    // shadow cache needs every set, and with access_partitioned. Enabling
+    // resets stats and flushes.
+    void enable_miss_classification(unsigned seen_bits = MissClassifier::kDefaultSeenBits);
+    void disable_miss_classification() { classifier.reset(); }
+    bool miss_classification_enabled() const { return classifier.has_value(); }
+    // Bitmap size of the last enable_miss_classification call.
+    unsigned miss_classification_seen_bits() const { return classifier_seen_bits; }
+
+    // All zero while classification is off.
+    MissClasses get_miss_classes() const;
+    uint64_t get_compulsory_misses() const { return get_miss_classes().compulsory; }
+    uint64_t get_capacity_misses() const { return get_miss_classes().capacity; }
+    int64_t  get_conflict_misses() const { return get_miss_classes().conflict; }
+
+    // --- Checkpointing ---
+    // Writes the warm state (tags, per-set fill state, replacement state
+    // and the RNG) in the format of checkpoint.h. Stats, timing, set
+    // sampling and miss-classification history are not part of it.
+    void save_checkpoint(std::ostream& out) const;
+
+    // Puts this cache in the state of a snapshot taken from a cache of the
+    // same geometry and policy, as if the references that warmed it had
+    // been replayed here; throws std::invalid_argument, leaving the cache
+    // unchanged, if the snapshot does not fit. Stats are zeroed, and an
+    // enabled miss classifier starts cold.
+    void restore_checkpoint(const CacheSnapshot& snapshot);
 
     // --- Getters ---
     uint64_t get_hits() const;
@@ -39,52 +159,296 @@ public:
     double   get_miss_rate() const;
     double   get_amat() const;
 
+    // --- Functional / timing split ---
+    // Hit/miss counts alone; hit/miss behavior never depends on timing, so
+    // callers can re-time one result with evaluate_timing() for any number
+    // of TimingParams instead of re-simulating.
+    FunctionalResult functional_result() const;
+    const TimingParams& timing_params() const { return timing; }
+    static constexpr ReplacementPolicy policy() { return Policy::kKind; }
+
+    // --- Geometry ---
+    size_t get_cache_size() const { return cache_size; }
+    size_t get_line_size() const { return line_size; }
+    size_t get_associativity() const { return associativity; }
+    size_t get_num_sets() const { return num_sets; }
+    size_t set_index(uint64_t address) const { return static_cast<size_t>(extract_index(address)); }
+
 private:
-    size_t cache_size;
-    size_t line_size;
-    size_t associativity;
-    size_t num_sets;
+    size_t cache_size = 0;
+    size_t line_size = 0;
+    size_t associativity = 0;
+    size_t num_sets = 0;
+
+    TimingParams timing;
 
-    size_t hit_latency;
-    size_t miss_penalty;
+    // Address decomposition, precomputed from the geometry. Power-of-two
+    // line sizes and set counts reduce to shifts and masks; anything else
+    // goes through a reciprocal multiply instead of a hardware divide.
+    FastDivider line_div;
+    FastDivider set_div;
+    uint64_t set_mask = 0;      // num_sets - 1 when num_sets is a power of two
 
-    ReplacementPolicy policy;
+    IStorage* next_level = nullptr;
 
-    uint64_t access_counter = 0;
+    // Vectorized tag compare for wide sets; null means scan inline.
+    TagMatchFn tag_match = nullptr;
 
-    MemoryTiming mem_timing{};
-    bool use_mem_timing = false;
+    // A fully-associative cache (one set) of at least kHashedMinWays finds
+    // lines through a hash index from tag to way instead of scanning, so
+    // with LRU both lookup and replacement are O(1) at any capacity. The
+    // index is emptied on the set's first reference after a flush.
+    static constexpr size_t kHashedMinWays = 32;
+    bool hashed = false;
+    LineIndex line_index;
 
-    struct CacheLine {
-        bool valid = false;
-        uint64_t tag = 0;
+    // Tag store, laid out structure-of-arrays. Entry for (set, way) lives at
+    // set * associativity + way, so one set's tags are contiguous in memory.
+    std::vector<uint64_t> tags;
 
-        // For replacement policies:
-        uint64_t last_used = 0;    // LRU
-        uint64_t inserted_at = 0;  // FIFO
+    // Per-set bookkeeping, read with one load per reference. Misses fill
+    // the lowest empty way and lines are only ever invalidated a whole set
+    // at a time, so the valid ways of a set are always exactly
+    // [0, filled): no per-way valid bits, no scan for a free way, and a
+    // full set goes straight to the policy. A set whose epoch differs from
+    // the cache's predates the last flush() and is empty. `mru` is the way
+    // last hit or filled, tried before the scan.
+    struct SetMeta {
+        uint32_t epoch = 0;
+        uint32_t filled = 0;
+        uint32_t mru = 0;
     };
+    std::vector<SetMeta> set_meta;
+    uint32_t epoch = 0;
+
+    Policy repl;
 
-    struct CacheSet {
-        std::vector<CacheLine> lines;
+    // Set sampling: per-set membership and per-sampled-set counts, both
+    // empty when every set is simulated.
+    struct SampleCounts {
+        uint64_t accesses = 0;
+        uint64_t misses = 0;
     };
+    std::vector<uint8_t>      set_sampled;
+    std::vector<SampleCounts> sample_counts;
+    size_t sampled_sets = 0;
 
-    std::vector<CacheSet> sets;
+    bool is_sampled(uint64_t index) const {
+        return set_sampled.empty() || set_sampled[static_cast<size_t>(index)];
+    }
+
+    std::optional<MissClassifier> classifier;
+    unsigned classifier_seen_bits = MissClassifier::kDefaultSeenBits;
+
+    // Counters for one stream of references. The cache's own
+    // stats live in `lane`; partitioned runs give each worker its own lane
+    // and merge the counters afterwards.
+    //
+    // Each lane also remembers the line its last reference touched and the
+    // way that line now occupies. Only the lane's own references change
+    // the sets it visits, so a repeat of that line is a hit in that way and
+    // needs no scan; flush() and partitioned runs forget it.
+    struct Lane {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t skipped = 0;        // dropped by set sampling
+        uint64_t* set_rng = nullptr; // per-set RNG streams, if any
 
-    // Stats
-    uint64_t hits = 0;
-    uint64_t misses = 0;
+        static constexpr size_t kNoSet = ~size_t(0);
+        size_t   last_set = kNoSet;
+        uint64_t last_tag = 0;
+        size_t   last_way = 0;
+    };
+
+    Lane lane;
 
-    // RNG for RANDOM policy
-    uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+    // RNG for RANDOM victims and BRRIP insertions
+    static constexpr uint64_t kRngSeed = 0x9e3779b97f4a7c15ULL;
+    uint64_t rng_state = kRngSeed;
 
     uint64_t extract_tag(uint64_t addr) const;
     uint64_t extract_index(uint64_t addr) const;
+    void split_address(uint64_t addr, uint64_t& index, uint64_t& tag) const;
+    void init_geometry();
+
+    // Shared by the constructor and reconfigure().
+    void configure(size_t cache_size, size_t line_size, size_t associativity, TimingParams timing);
 
-    CacheLine* pick_victim(CacheSet& set);
+    // Lookup + fill for one reference that has already been decomposed.
+    // kCount == false updates tags and replacement state only (warm()).
+    template <bool kCount>
+    bool access_line(uint64_t index, uint64_t tag, Lane& ln);
+
+    template <bool kCount>
+    void count_hit(size_t set, Lane& ln) {
+        if (!kCount) return;
+        ln.hits++;
+        if (!sample_counts.empty()) sample_counts[set].accesses++;
+    }
+
+    // Returns the way among the first `ways` of the set at `base` holding
+    // `tag`, or associativity if none does.
+    size_t find_way(size_t base, size_t ways, uint64_t tag) const;
     uint64_t next_rand();
 
+    // Calls f(i, index, tag) for each address in order, decomposing and
+    // prefetching a few references ahead.
+    template <typename F>
+    void for_each_staged(const uint64_t* addresses, size_t count, F&& f);
+
+    // Latency of a miss on `address`, forwarding to next_level if linked.
+    uint64_t miss_latency(uint64_t address);
+
     size_t effective_miss_penalty_cycles() const {
-        if (use_mem_timing) return mem_timing.miss_service_cycles(line_size);
-        return miss_penalty;
+        return timing.miss_penalty_cycles(line_size);
     }
 };
+
+extern template class BasicCache<LruPolicy>;
+extern template class BasicCache<FifoPolicy>;
+extern template class BasicCache<RandomPolicy>;
+extern template class BasicCache<TreePlruPolicy>;
+extern template class BasicCache<BitPlruPolicy>;
+extern template class BasicCache<SrripPolicy>;
+extern template class BasicCache<BrripPolicy>;
+
+// Cache with the replacement policy chosen at run time. Holds one
+// BasicCache instantiation and forwards to it, so the policy is dispatched
+// once per call: once per reference through access(), once per batch
+// through access_batch(). Loops that want no per-call dispatch at all can
+// run inside visit(), which hands them the concrete BasicCache.
+class Cache final : public IStorage {
+public:
+    Cache(size_t cache_size,
+          size_t line_size,
+          size_t associativity,
+          size_t hit_latency,
+          size_t miss_penalty,
+          ReplacementPolicy policy = ReplacementPolicy::LRU);
+        
+    //New Constructor for realistic miss penalty
+    Cache(size_t cache_size,
+          size_t line_size,
+          size_t associativity,
+          size_t hit_latency,
+          MemoryTiming mem_timing,
+          ReplacementPolicy policy = ReplacementPolicy::LRU);
+
+    Cache(size_t cache_size,
+          size_t line_size,
+          size_t associativity,
+          TimingParams timing,
+          ReplacementPolicy policy = ReplacementPolicy::LRU);
+
+    // BasicCache::reconfigure when `policy` is the current one; a different
+    // policy needs a new concrete cache, so that case allocates afresh but
+    // keeps the next-level link and miss classification (with its seen_bits).
+    void reconfigure(size_t cache_size,
+                     size_t line_size,
+                     size_t associativity,
+                     TimingParams timing,
+                     ReplacementPolicy policy);
+
+    // Calls f(BasicCache<P>&) with the concrete cache.
+    template <typename F>
+    decltype(auto) visit(F&& f) { return std::visit(std::forward<F>(f), impl); }
+    template <typename F>
+    decltype(auto) visit(F&& f) const { return std::visit(std::forward<F>(f), impl); }
+
+    // See BasicCache for the semantics of each call.
+    bool access(uint64_t address, uint64_t& latency) override {
+        return visit([&](auto& c) { return c.access(address, latency); });
+    }
+    bool lookup(uint64_t address) {
+        return visit([&](auto& c) { return c.lookup(address); });
+    }
+
+    void warm(const uint64_t* addresses, size_t count) {
+        visit([&](auto& c) { c.warm(addresses, count); });
+    }
+
+    void set_next_level(IStorage* next) { visit([&](auto& c) { c.set_next_level(next); }); }
+    IStorage* get_next_level() const { return visit([](const auto& c) { return c.get_next_level(); }); }
+
+    BatchStats access_batch(const uint64_t* addresses,
+                            size_t count,
+                            const uint8_t* is_write = nullptr,
+                            AccessResult* results = nullptr) {
+        return visit([&](auto& c) { return c.access_batch(addresses, count, is_write, results); });
+    }
+
+    BatchStats access_partitioned(const uint64_t* addresses, size_t count, ThreadPool& pool) {
+        return visit([&](auto& c) { return c.access_partitioned(addresses, count, pool); });
+    }
+
+    void print_stats() const { visit([](const auto& c) { c.print_stats(); }); }
+    void reset_stats() override { visit([](auto& c) { c.reset_stats(); }); }
+    void flush() { visit([](auto& c) { c.flush(); }); }
+
+    void enable_set_sampling(size_t ratio, uint64_t seed = 0) {
+        visit([&](auto& c) { c.enable_set_sampling(ratio, seed); });
+    }
+    void disable_set_sampling() { visit([](auto& c) { c.disable_set_sampling(); }); }
+    bool set_sampling_enabled() const { return visit([](const auto& c) { return c.set_sampling_enabled(); }); }
+    SetSampleEstimate set_sample_estimate(double z = 1.96) const {
+        return visit([&](const auto& c) { return c.set_sample_estimate(z); });
+    }
+    double get_miss_rate_ci(double z = 1.96) const { return set_sample_estimate(z).ci_half_width; }
+
+    void enable_miss_classification(unsigned seen_bits = MissClassifier::kDefaultSeenBits) {
+        visit([&](auto& c) { c.enable_miss_classification(seen_bits); });
+    }
+    void disable_miss_classification() { visit([](auto& c) { c.disable_miss_classification(); }); }
+    bool miss_classification_enabled() const {
+        return visit([](const auto& c) { return c.miss_classification_enabled(); });
+    }
+    unsigned miss_classification_seen_bits() const {
+        return visit([](const auto& c) { return c.miss_classification_seen_bits(); });
+    }
+    MissClasses get_miss_classes() const { return visit([](const auto& c) { return c.get_miss_classes(); }); }
+
+    // Throws std::runtime_error if `path` cannot be written.
+    void save_checkpoint(const std::string& path) const;
+    void save_checkpoint(std::ostream& out) const { visit([&](const auto& c) { c.save_checkpoint(out); }); }
+    void restore_checkpoint(const CacheSnapshot& snapshot) {
+        visit([&](auto& c) { c.restore_checkpoint(snapshot); });
+    }
+    uint64_t get_compulsory_misses() const { return get_miss_classes().compulsory; }
+    uint64_t get_capacity_misses() const { return get_miss_classes().capacity; }
+    int64_t  get_conflict_misses() const { return get_miss_classes().conflict; }
+
+    uint64_t get_hits() const { return visit([](const auto& c) { return c.get_hits(); }); }
+    uint64_t get_misses() const { return visit([](const auto& c) { return c.get_misses(); }); }
+    uint64_t get_accesses() const { return visit([](const auto& c) { return c.get_accesses(); }); }
+    double   get_miss_rate() const { return visit([](const auto& c) { return c.get_miss_rate(); }); }
+    double   get_amat() const { return visit([](const auto& c) { return c.get_amat(); }); }
+
+    FunctionalResult functional_result() const {
+        return visit([](const auto& c) { return c.functional_result(); });
+    }
+    const TimingParams& timing_params() const {
+        return visit([](const auto& c) -> const TimingParams& { return c.timing_params(); });
+    }
+    ReplacementPolicy policy() const {
+        return visit([](const auto& c) { return c.policy(); });
+    }
+
+    size_t get_cache_size() const { return visit([](const auto& c) { return c.get_cache_size(); }); }
+    size_t get_line_size() const { return visit([](const auto& c) { return c.get_line_size(); }); }
+    size_t get_associativity() const { return visit([](const auto& c) { return c.get_associativity(); }); }
+    size_t get_num_sets() const { return visit([](const auto& c) { return c.get_num_sets(); }); }
+    size_t set_index(uint64_t address) const {
+        return visit([&](const auto& c) { return c.set_index(address); });
+    }
+
+private:
+    using Impl = std::variant<BasicCache<LruPolicy>, BasicCache<FifoPolicy>,
+                              BasicCache<RandomPolicy>, BasicCache<TreePlruPolicy>,
+                              BasicCache<BitPlruPolicy>, BasicCache<SrripPolicy>,
+                              BasicCache<BrripPolicy>>;
+
+    static Impl make_impl(size_t cache_size, size_t line_size, size_t associativity,
+                          TimingParams timing, ReplacementPolicy policy);
+
+    Impl impl;
+};
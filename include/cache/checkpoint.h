@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "cache/cache_model.h"
+#include "cache/mapped_file.h"
+#include "cache/replacement_policy.h"
+#include "cache/timing.h"
+
+// -----------------------------
+// Cache checkpoint format (.cmk)
+// -----------------------------
+//
+// All integers are little-endian.
+//
+// Header, 64 bytes:
+//   offset  size  field
+//        0     8  magic          "CMCKPT01"
+//        8     4  version        1
+//       12     4  policy         ReplacementPolicy value
+//       16     8  cache_size     bytes
+//       24     8  line_size      bytes
+//       32     8  associativity
+//       40     8  rng_state      the cache's RNG (RANDOM victims, BRRIP fills)
+//       48     4  epoch          the cache's flush epoch
+//       52     4  section_count
+//       56     8  checksum       over every byte after the header
+//
+// Followed by section_count sections, each a u64 byte count and that many
+// bytes, padded to a multiple of 8. In order: the tag store (u64 per way,
+// set-major), the per-set metadata (epoch, filled ways, MRU way; u32
+// each), then the replacement policy's state arrays in the order of its
+// state_arrays(). Array sizes follow from the geometry, so a restore
+// checks every section against the cache it fills.
+
+struct CheckpointHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t policy;
+    uint64_t cache_size;
+    uint64_t line_size;
+    uint64_t associativity;
+    uint64_t rng_state;
+    uint32_t epoch;
+    uint32_t section_count;
+    uint64_t checksum;
+};
+static_assert(sizeof(CheckpointHeader) == 64, "checkpoint header must be 64 bytes");
+
+constexpr uint32_t kCheckpointVersion = 1;
+
+// One array of cache state, as written or mapped.
+struct CheckpointSection {
+    const void* data = nullptr;
+    size_t bytes = 0;
+};
+
+// Writes `header` (magic, version, section count and checksum filled in
+// here) and the sections. Throws std::runtime_error if the stream fails.
+void write_checkpoint(std::ostream& out, CheckpointHeader header,
+                      const std::vector<CheckpointSection>& sections);
+
+// A checkpoint file mapped read-only. Restoring copies straight out of the
+// mapping, and the snapshot is never modified, so any number of caches, on
+// any threads, can be restored from one CacheSnapshot at once.
+class CacheSnapshot {
+public:
+    // Maps and validates `path` (magic, version, section layout and
+    // checksum); throws std::runtime_error on any mismatch.
+    explicit CacheSnapshot(const std::string& path);
+
+    const CheckpointHeader& header() const { return head; }
+    ReplacementPolicy policy() const { return static_cast<ReplacementPolicy>(head.policy); }
+    size_t cache_size() const { return static_cast<size_t>(head.cache_size); }
+    size_t line_size() const { return static_cast<size_t>(head.line_size); }
+    size_t associativity() const { return static_cast<size_t>(head.associativity); }
+
+    size_t section_count() const { return sections.size(); }
+    const CheckpointSection& section(size_t i) const { return sections.at(i); }
+
+    // A new cache of the snapshot's geometry and policy, in its state, with
+    // the given timing (which the checkpoint does not record).
+    Cache make_cache(TimingParams timing) const;
+
+private:
+    MappedFile file;
+    CheckpointHeader head{};
+    std::vector<CheckpointSection> sections;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "cache/line_index.h"
+
+// Fully-associative LRU set of line addresses with O(1) access: a
+// LineIndex maps a line to its node, and the nodes form an intrusive
+// doubly-linked recency list with the MRU line at the head. Node storage
+// is allocated once for the full capacity, so steady-state accesses never
+// allocate.
+class FullyAssociativeLru {
+public:
+    // Throws std::invalid_argument unless 0 < capacity < 2^31.
+    explicit FullyAssociativeLru(size_t capacity) { reset(capacity); }
+
+    // Empties the set and resizes it for `capacity`, reusing its memory.
+    void reset(size_t capacity);
+
+    // References `line`; returns true if it was present. A missing line is
+    // installed as MRU, evicting the LRU line when the set is full.
+    bool access(uint64_t line);
+
+    bool contains(uint64_t line) const { return index.find(line) != LineIndex::kNone; }
+
+    // Forgets every line.
+    void clear();
+
+    size_t size() const { return live; }
+    size_t capacity() const { return nodes.size(); }
+
+private:
+    static constexpr uint32_t kNone = LineIndex::kNone;
+
+    struct Node {
+        uint64_t line = 0;
+        uint32_t prev = kNone;      // toward the MRU end
+        uint32_t next = kNone;      // toward the LRU end
+    };
+
+    void unlink(uint32_t n);
+    void push_front(uint32_t n);
+
+    std::vector<Node> nodes;
+    LineIndex index;
+    uint32_t head = kNone;
+    uint32_t tail = kNone;
+    size_t live = 0;
+};
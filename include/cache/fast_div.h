@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+
+// Unsigned 64-bit division by a runtime-constant divisor.
+//
+// Powers of two reduce to a shift. Other divisors use a precomputed
+// reciprocal ("magic number") so that n / d becomes a multiply-high plus
+// shifts, in the style of Granlund & Montgomery / libdivide.
+struct FastDivider {
+    FastDivider() = default;
+
+    explicit FastDivider(uint64_t d) : divisor(d) {
+        if (d == 0) return;
+
+        const unsigned log2_d = 63u - static_cast<unsigned>(__builtin_clzll(d));
+        if ((d & (d - 1)) == 0) {
+            is_pow2 = true;
+            shift = log2_d;
+            return;
+        }
+        is_pow2 = false;
+
+        // m = floor(2^(64 + log2_d) / d); the quotient fits in 64 bits since
+        // 2^log2_d < d.
+        const u128 numerator = static_cast<u128>(uint64_t{1} << log2_d) << 64;
+        uint64_t m = static_cast<uint64_t>(numerator / d);
+        const uint64_t rem = static_cast<uint64_t>(numerator % d);
+
+        if (d - rem < (uint64_t{1} << log2_d)) {
+            // The reciprocal fits in 64 bits.
+            shift = log2_d;
+        } else {
+            // Needs a 65-bit reciprocal: keep the low 64 bits and fix up with
+            // the add-and-halve sequence in divide().
+            m += m;
+            const uint64_t twice_rem = rem + rem;
+            if (twice_rem >= d || twice_rem < rem) m += 1;
+            shift = log2_d;
+            needs_add = true;
+        }
+        magic = m + 1;
+    }
+
+    uint64_t divide(uint64_t n) const {
+        if (is_pow2) return n >> shift;
+        const uint64_t q = static_cast<uint64_t>((static_cast<u128>(magic) * n) >> 64);
+        if (!needs_add) return q >> shift;
+        return (((n - q) >> 1) + q) >> shift;
+    }
+
+    uint64_t divisor = 1;
+    uint64_t magic = 0;
+    unsigned shift = 0;
+    bool is_pow2 = true;
+    bool needs_add = false;
+
+private:
+    __extension__ typedef unsigned __int128 u128;
+};
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "cache/cache_model.h"
+#include "cache/memory.h"
+#include "cache/storage.h"
+#include "cache/types.h"
+
+// Multi-level hierarchy composed at compile time, e.g.
+//
+//     CacheHierarchy<BasicCache<LruPolicy>, BasicCache<LruPolicy>,
+//                    BasicCache<SrripPolicy>, Memory> h(l1, l2, llc, dram);
+//
+// Every level but the last is probed with lookup() and contributes its hit
+// latency; a miss falls through to the next level. The last level services
+// whatever reaches it through access(). Levels are held by value and the
+// chain is unrolled with if constexpr, so none of the per-reference calls
+// go through IStorage's vtable (BasicCache and Memory are final). Cache
+// works as a level too, at the cost of one policy dispatch per probe.
+//
+// Each level keeps its own hit/miss counters; the hierarchy's latency
+// replaces each cache's own miss penalty, which is ignored here.
+template <typename... Levels>
+class CacheHierarchy {
+public:
+    static_assert(sizeof...(Levels) >= 1, "a hierarchy needs at least one level");
+    static constexpr size_t kLevels = sizeof...(Levels);
+
+    explicit CacheHierarchy(Levels... levels) : levels(std::move(levels)...) {}
+
+    // Returns whether the first level hit; `latency` covers every level
+    // the reference reached.
+    bool access(uint64_t address, uint64_t& latency) {
+        bool hit = false;
+        latency = access_from<0>(address, hit);
+        return hit;
+    }
+
+    // Simulates `count` references in order. Hit/miss counts in the result
+    // are those of the first level; total_latency covers the hierarchy.
+    BatchStats access_batch(const uint64_t* addresses,
+                            size_t count,
+                            const uint8_t* is_write = nullptr,
+                            AccessResult* results = nullptr) {
+        BatchStats stats;
+        stats.accesses = count;
+        for (size_t i = 0; i < count; i++) {
+            bool hit = false;
+            const uint64_t lat = access_from<0>(addresses[i], hit);
+            stats.hits += hit;
+            stats.total_latency += lat;
+            if (is_write) stats.writes += is_write[i] != 0;
+            if (results) {
+                results[i].hit = hit;
+                results[i].latency = lat;
+            }
+        }
+        stats.misses = count - stats.hits;
+        stats.reads = count - stats.writes;
+        return stats;
+    }
+
+    // Counters only, on every level; contents stay warm.
+    void reset_stats() {
+        std::apply([](auto&... lv) { (lv.reset_stats(), ...); }, levels);
+    }
+
+    // Invalidates every cache level.
+    void flush() {
+        std::apply([](auto&... lv) { (flush_level(lv), ...); }, levels);
+    }
+
+    template <size_t I>
+    auto& level() { return std::get<I>(levels); }
+
+    template <size_t I>
+    const auto& level() const { return std::get<I>(levels); }
+
+private:
+    template <typename Level>
+    static void flush_level(Level& lv) { lv.flush(); }
+    static void flush_level(Memory&) {}
+
+    template <size_t I>
+    uint64_t access_from(uint64_t address, bool& first_hit) {
+        auto& lv = std::get<I>(levels);
+        if constexpr (I + 1 == kLevels) {
+            uint64_t lat = 0;
+            const bool hit = lv.access(address, lat);
+            if constexpr (I == 0) first_hit = hit;
+            return lat;
+        } else {
+            const uint64_t hit_lat = lv.timing_params().hit_latency;
+            const bool hit = lv.lookup(address);
+            if constexpr (I == 0) first_hit = hit;
+            if (hit) return hit_lat;
+            return hit_lat + access_from<I + 1>(address, first_hit);
+        }
+    }
+
+    std::tuple<Levels...> levels;
+};
+
+// Hierarchy assembled at run time, for stacks whose depth is only known
+// from a config file. Levels are chained with Cache::set_next_level, so each
+// miss costs one virtual call per level it falls through; prefer
+// CacheHierarchy when the shape is fixed.
+class RuntimeHierarchy final : public IStorage {
+public:
+    explicit RuntimeHierarchy(Memory memory);
+
+    // Appends `cache` below the current last cache level; returns its index.
+    size_t add_level(Cache cache);
+
+    size_t levels() const { return caches.size(); }
+    Cache&       level(size_t i) { return *caches[i]; }
+    const Cache& level(size_t i) const { return *caches[i]; }
+    Memory&       memory() { return *mem; }
+    const Memory& memory() const { return *mem; }
+
+    bool access(uint64_t address, uint64_t& latency) override;
+
+    // Same contract as CacheHierarchy::access_batch.
+    BatchStats access_batch(const uint64_t* addresses,
+                            size_t count,
+                            const uint8_t* is_write = nullptr,
+                            AccessResult* results = nullptr);
+
+    void reset_stats() override;
+    void flush();
+
+private:
+    // Levels and memory are heap-allocated so the next-level links stay
+    // valid when the hierarchy is moved.
+    std::vector<std::unique_ptr<Cache>> caches;
+    std::unique_ptr<Memory> mem;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+// Hardware event counters of the calling thread, read through Linux
+// perf_event: host cycles, retired instructions and last-level cache
+// misses, user space only. Used to profile the simulator itself. If the
+// cycle counter cannot be opened (not Linux, no PMU in a VM, a restrictive
+// perf_event_paranoid), valid() is false and nothing is measured; any
+// other event the PMU lacks is only missing from the samples, which flag
+// each count that was actually read.
+class HostCounters {
+public:
+    struct Sample {
+        uint64_t cycles = 0;
+        uint64_t instructions = 0;
+        uint64_t llc_misses = 0;
+        // Whether each count above was measured; unmeasured ones are 0.
+        bool has_cycles = false;
+        bool has_instructions = false;
+        bool has_llc_misses = false;
+    };
+
+    // Opens the counters for the calling thread, stopped. Counts only
+    // that thread, so construct it on the thread being measured.
+    HostCounters();
+    ~HostCounters();
+
+    HostCounters(const HostCounters&) = delete;
+    HostCounters& operator=(const HostCounters&) = delete;
+
+    // The cycle counter, which leads the group, is open.
+    bool valid() const { return fds[0] >= 0; }
+
+    // Zeroes and starts the counters.
+    void start();
+
+    // Stops the counters and returns the counts since start().
+    Sample stop();
+
+private:
+    int fds[3] = {-1, -1, -1};      // cycles (group leader), instructions, LLC misses
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cache/spsc_ring.h"
+#include "cache/types.h"
+
+class Cache;
+class TraceSource;
+
+// Counters of one interval of a time-series run. `accesses` counts every
+// reference consumed, including ones dropped by set sampling; the rates
+// are over the simulated ones.
+struct IntervalRecord {
+    uint64_t index = 0;             // 0-based interval number
+    uint64_t start = 0;             // index of the interval's first reference
+    uint64_t accesses = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t total_latency = 0;     // cycles, as in BatchStats
+
+    double miss_rate() const {
+        const uint64_t n = hits + misses;
+        return n ? static_cast<double>(misses) / static_cast<double>(n) : 0.0;
+    }
+    double amat() const {
+        const uint64_t n = hits + misses;
+        return n ? static_cast<double>(total_latency) / static_cast<double>(n) : 0.0;
+    }
+};
+
+// -----------------------------
+// Time-series file formats
+// -----------------------------
+//
+// CSV: a header line, then one line per interval:
+//   interval,start,accesses,hits,misses,miss_rate,amat[,set_0,...,set_N-1]
+// with per-set hit counts when the writer has set columns.
+//
+// Binary (.cms), little-endian:
+//   header, 32 bytes: magic "CMSERIES" (8), version u32 = 1,
+//                     set_columns u32, interval u64, reserved (8, zero)
+//   per interval:     index, start, accesses, hits, misses, total_latency
+//                     (u64 each), then u32 set_hits[set_columns]
+
+constexpr uint32_t kTimeSeriesVersion = 1;
+
+// Writes interval records on a background thread. The simulation thread
+// fills preallocated slots and hands them over through a lock-free ring
+// (SpscRing), so it never waits on the file; it only waits, yielding,
+// if the writer has fallen a whole ring of records behind.
+class TimeSeriesWriter {
+public:
+    enum class Format { Csv, Binary };
+
+    // Opens `path` (throws std::runtime_error on failure) and starts the
+    // writer thread. set_columns is the number of per-set hit counts per
+    // record, 0 for none; `slots` bounds the records in flight.
+    TimeSeriesWriter(const std::string& path, Format format, uint64_t interval,
+                     size_t set_columns = 0, size_t slots = 256);
+
+    // Closes the file; errors are swallowed here, call close() to see them.
+    ~TimeSeriesWriter();
+
+    TimeSeriesWriter(const TimeSeriesWriter&) = delete;
+    TimeSeriesWriter& operator=(const TimeSeriesWriter&) = delete;
+
+    // Producer side: acquire() returns a free record and, when the writer
+    // has set columns, its set_columns() counts in `set_hits`; publish()
+    // queues it. Calls must alternate.
+    IntervalRecord& acquire(uint32_t*& set_hits);
+    void publish();
+
+    // Writes everything queued, stops the thread and closes the file.
+    // Throws std::runtime_error if any write failed. Idempotent.
+    void close();
+
+    size_t set_columns() const { return columns; }
+
+    // Times acquire() found no free slot.
+    uint64_t producer_waits() const { return waits; }
+
+private:
+    static constexpr uint32_t kNoSlot = 0xffffffffu;
+
+    void drain();
+    void write_header(uint64_t interval);
+    void write_record(uint32_t slot);
+
+    std::ofstream out;
+    Format format;
+    size_t columns;
+
+    std::vector<IntervalRecord> records;    // one per slot
+    std::vector<uint32_t> set_hits;         // columns per slot
+    SpscRing<uint32_t> free_slots;          // writer -> producer
+    SpscRing<uint32_t> full_slots;          // producer -> writer
+    uint32_t current = kNoSlot;             // slot acquired, not yet published
+    uint64_t waits = 0;
+
+    std::atomic<bool> closing{false};
+    std::exception_ptr error;               // first write failure, writer thread only
+    std::thread thread;
+};
+
+struct IntervalStatsConfig {
+    uint64_t interval = 100000;     // references per interval
+    bool per_set_hits = false;      // also count hits per set
+};
+
+// Cuts a cache's reference stream into fixed-length intervals and records
+// each one's counters: in memory (history()) and, given a writer, in a
+// time-series file. Phase behavior that an end-of-run total averages away
+// shows up in a single run. Collects from the BatchStats of each
+// Cache::access_batch call, so the cache's own counters keep running
+// totals and are not reset between intervals.
+class IntervalStatsCollector {
+public:
+    // Throws std::invalid_argument if interval is 0, if per_set_hits is set
+    // without a writer, or if the writer's set columns are not one per
+    // cache set (per_set_hits) or zero (otherwise).
+    IntervalStatsCollector(Cache& cache, IntervalStatsConfig config, TimeSeriesWriter* writer = nullptr);
+
+    void access_batch(const uint64_t* addresses, size_t count, const uint8_t* is_write = nullptr);
+
+    // Drains `source` through access_batch, then finish().
+    void run(TraceSource& source);
+
+    // Emits the trailing partial interval, if any.
+    void finish();
+
+    // Every interval emitted so far (without per-set counts).
+    const std::vector<IntervalRecord>& history() const { return records; }
+
+private:
+    void emit();
+
+    Cache& cache;
+    IntervalStatsConfig config;
+    TimeSeriesWriter* writer;
+
+    IntervalRecord cur;
+    std::vector<uint32_t> cur_set_hits;
+    std::vector<AccessResult> results;      // per-reference outcomes, per_set_hits only
+    std::vector<IntervalRecord> records;
+};
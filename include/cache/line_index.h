@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Open-addressed hash map from line address to a 32-bit slot number (a
+// way, a list node), sized once for a fixed number of live entries.
+// Linear probing with backward-shift deletion, so there are no tombstones
+// and probe sequences stay short however many inserts and erases a long
+// run performs. Keys are stored inline: a lookup touches only the table.
+// Entries carry the generation they were written in, so clear() is O(1):
+// it starts a new generation, and entries of older ones read as empty.
+class LineIndex {
+public:
+    static constexpr uint32_t kNone = 0xffffffffu;
+
+    LineIndex() = default;
+
+    // Room for `capacity` live entries; throws std::invalid_argument unless
+    // 0 < capacity < 2^31.
+    explicit LineIndex(size_t capacity) { reset(capacity); }
+
+    // Empties the index and resizes it for `capacity`, reusing the table's
+    // memory when it is large enough. Same requirements as the constructor.
+    void reset(size_t capacity);
+
+    // Value stored for `line`, or kNone.
+    uint32_t find(uint64_t line) const {
+        size_t slot = home(line);
+        while (live(slot)) {
+            if (table[slot].line == line) return table[slot].value;
+            slot = (slot + 1) & mask;
+        }
+        return kNone;
+    }
+
+    // `line` must be absent and the index below capacity.
+    void insert(uint64_t line, uint32_t value);
+
+    // No-op if `line` is absent.
+    void erase(uint64_t line);
+
+    // Empties the index in O(1), except once every 2^32 calls, when the
+    // generation wraps and the table is wiped.
+    void clear();
+
+private:
+    struct Entry {
+        uint64_t line = 0;
+        uint32_t value = kNone;     // kNone marks an empty slot
+        uint32_t generation = 0;    // live only in the current generation
+    };
+
+    bool live(size_t slot) const {
+        return table[slot].value != kNone && table[slot].generation == generation;
+    }
+
+    size_t home(uint64_t line) const {
+        return static_cast<size_t>((line * 0x9e3779b97f4a7c15ULL) >> shift);
+    }
+
+    std::vector<Entry> table;
+    size_t mask = 0;
+    unsigned shift = 0;             // 64 - log2(table size)
+    uint32_t generation = 0;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Read-only POSIX memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    // Maps `path`; throws std::runtime_error if it cannot be opened or mapped.
+    // `sequential` adds an madvise(MADV_SEQUENTIAL) read-ahead hint.
+    explicit MappedFile(const std::string& path, bool sequential = true);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return base; }
+    size_t size() const { return bytes; }
+
+private:
+    void release();
+
+    const uint8_t* base = nullptr;
+    size_t bytes = 0;
+};
@@ -5,7 +5,7 @@
 #include "cache/storage.h"
 #include "cache/types.h"   // MemoryTiming (fixed latency + bytes_per_cycle)
 
-class Memory : public IStorage {
+class Memory final : public IStorage {
 public:
     // line_size_bytes here is the transfer granularity (we’ll use L2 line size typically)
     Memory(MemoryTiming timing, size_t line_size_bytes)
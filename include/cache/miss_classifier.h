@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "cache/fa_lru.h"
+#include "cache/types.h"
+
+// Compulsory / capacity / conflict classification for one cache. Sees the
+// same line references as the cache and keeps:
+//  - a hashed first-touch bitmap: a line whose bit is clear is a
+//    compulsory miss. Memory stays fixed however large the footprint; a
+//    hash collision makes a first touch look like a repeat, so compulsory
+//    misses can only be undercounted (and capacity overcounted by as many);
+//  - a shadow fully-associative LRU cache of the same capacity; its misses
+//    split into compulsory and capacity, the remainder of the real cache's
+//    misses is conflict.
+// clear() is O(1), like a cache flush: the bitmap is cut into blocks that
+// carry the epoch they were last cleared in, and a block is zeroed on its
+// first use after the epoch moves on.
+class MissClassifier {
+public:
+    static constexpr unsigned kDefaultSeenBits = 24;    // 2 MB bitmap
+
+    // capacity_lines: lines in the classified cache. The bitmap holds
+    // 2^seen_bits bits; throws std::invalid_argument unless 6 <= seen_bits <= 36.
+    explicit MissClassifier(size_t capacity_lines, unsigned seen_bits = kDefaultSeenBits);
+
+    // As if newly constructed, but reusing the bitmap and shadow storage.
+    void reset(size_t capacity_lines, unsigned seen_bits = kDefaultSeenBits);
+
+    // One reference to `line`. count == false updates the state only
+    // (functional warming).
+    void observe(uint64_t line, bool count) {
+        const bool first = test_and_set(line);
+        const bool shadow_hit = shadow.access(line);
+        if (!count) return;
+        first_touches += first;
+        shadow_misses += !shadow_hit;
+    }
+
+    // Breakdown of `misses` real-cache misses counted over the same references.
+    MissClasses classes(uint64_t misses) const;
+
+    // Zeroes the counts; history stays warm.
+    void reset_counts();
+
+    // Forgets every line, as after a cache flush.
+    void clear();
+
+private:
+    static constexpr size_t kBlockWords = 64;   // 512-byte bitmap blocks
+
+    bool test_and_set(uint64_t line) {
+        uint64_t h = line * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+        const uint64_t bit = (h * 0x94d049bb133111ebULL) >> seen_shift;
+        const size_t w = static_cast<size_t>(bit >> 6);
+        if (block_epoch[w / kBlockWords] != epoch) clear_block(w / kBlockWords);
+        uint64_t& word = seen[w];
+        const uint64_t mask = 1ULL << (bit & 63);
+        const bool first = (word & mask) == 0;
+        word |= mask;
+        return first;
+    }
+
+    void clear_block(size_t block);
+    void assign_bitmap(unsigned seen_bits);
+
+    std::vector<uint64_t> seen;
+    std::vector<uint32_t> block_epoch;      // epoch each block was last zeroed in
+    uint32_t epoch = 0;
+    unsigned seen_shift = 0;
+    FullyAssociativeLru shadow;
+    uint64_t first_touches = 0;
+    uint64_t shadow_misses = 0;
+};
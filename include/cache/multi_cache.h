@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "cache/cache_model.h"
+#include "cache/trace_source.h"
+
+class ThreadPool;
+
+// Feeds one trace to many independent Cache instances in a single pass.
+//
+// Each incoming chunk is cut into blocks small enough to stay in the host's
+// L1/L2, and every cache consumes a block before the next block is read, so
+// the trace is decoded once no matter how many configurations are driven.
+// With a pool, the caches are split into contiguous config groups and each
+// group runs on its own worker; every cache still sees the references in
+// trace order, so results do not depend on the grouping.
+class MultiCacheDriver {
+public:
+    // pool == nullptr runs every cache on the calling thread. groups == 0
+    // uses one group per pool worker.
+    explicit MultiCacheDriver(ThreadPool* pool = nullptr, size_t groups = 0);
+
+    // Takes ownership of `cache`; returns its index.
+    size_t add(Cache cache);
+
+    size_t size() const { return caches.size(); }
+    Cache&       at(size_t i) { return caches[i]; }
+    const Cache& at(size_t i) const { return caches[i]; }
+
+    // Hands the caches back (e.g. to be reconfigured for the next pass) and
+    // leaves the driver empty.
+    std::vector<Cache> release();
+
+    void access_batch(const uint64_t* addresses, size_t count, const uint8_t* is_write = nullptr);
+
+    // Drains `source` through access_batch.
+    void run(TraceSource& source);
+
+private:
+    void feed_range(size_t first, size_t last,
+                    const uint64_t* addresses, size_t count, const uint8_t* is_write);
+
+    static constexpr size_t kBlockRefs = 2048;   // 16 KB of addresses
+
+    std::vector<Cache> caches;
+    ThreadPool* pool;
+    size_t groups;
+};
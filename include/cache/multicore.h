@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "cache/cache_model.h"
+#include "cache/trace_source.h"
+
+class ThreadPool;
+
+struct MultiCoreConfig {
+    enum class Mode {
+        // Cores run in parallel in epochs of `quantum` cycles: each core
+        // simulates its private levels for one epoch, queuing the
+        // references that miss them, then the LLC slices service all
+        // queued references in parallel, in issue-time order. Within an
+        // epoch a core assumes every LLC access hits; the real latency is
+        // charged to its clock when the epoch closes, so cores drift from
+        // the exact interleaving by at most about one quantum.
+        Epochs,
+        // Exact reference: one host thread always advances the core with
+        // the earliest clock (lowest index on ties) by one reference,
+        // through its private levels and the LLC, with real latencies.
+        Serialized
+    };
+
+    Mode mode = Mode::Epochs;
+    uint64_t quantum = 10000;   // cycles per epoch (Epochs)
+    // LLC slices, each an independent cache holding an equal share of the
+    // sets; 0 means one per core. Capped to a power of two dividing the
+    // LLC's set count. Hit/miss behavior does not depend on the slice
+    // count except for the randomized policies, whose RNG is per slice.
+    size_t llc_slices = 0;
+};
+
+// Counters of one simulated core after run().
+struct CoreStats {
+    uint64_t references = 0;
+    uint64_t llc_accesses = 0;      // references that missed every private level
+    uint64_t llc_misses = 0;
+    uint64_t cycles = 0;            // the core's clock: sum of its references' latencies
+};
+
+// Simulates `cores` in-order cores, each with private cache levels (e.g.
+// L1, L2) in front of one shared last-level cache, each core driven by its
+// own trace. A core issues one reference at a time and waits for it; its
+// clock advances by the reference's latency, computed as in
+// CacheHierarchy: the hit latency of every private level probed, plus the
+// LLC's access latency (its hit latency, plus its miss penalty on a miss)
+// when all private levels miss. Private levels are non-inclusive and
+// coherence is not modeled, so a core's private hit/miss behavior depends
+// only on its own trace; cores interact through the LLC's contents and the
+// order their misses reach it.
+//
+// The LLC is split by set into slices that run independently: set s of the
+// LLC becomes set s / slices of slice s % slices, which keeps its behavior
+// identical to the undivided cache for the deterministic policies.
+// Neither mode takes a lock per reference: in Epochs, cores hand LLC
+// requests over through per-core, per-slice queues that are only read
+// after the phase that wrote them has finished.
+class MultiCoreSimulator {
+public:
+    // Every core gets a copy of `private_levels` (first = closest to the
+    // core; may be empty). `llc` is the shared cache's geometry, policy and
+    // timing. Throws std::invalid_argument if cores is 0, the quantum is
+    // 0, or the LLC has a next level linked (its miss latency must come
+    // from its own timing).
+    MultiCoreSimulator(size_t cores,
+                       const std::vector<Cache>& private_levels,
+                       const Cache& llc,
+                       MultiCoreConfig config = {});
+
+    // Runs each core's trace (traces[i] drives core i) to the end; throws
+    // std::invalid_argument unless there is one trace per core. Caches and
+    // counters carry over between calls. Epochs mode runs the cores and
+    // then the slices on `pool`, or on the calling thread if null.
+    void run(const std::vector<TraceSource*>& traces, ThreadPool* pool = nullptr);
+
+    size_t cores() const { return core_state.size(); }
+    const CoreStats& core_stats(size_t core) const { return core_state.at(core).stats; }
+    const Cache& private_level(size_t core, size_t level) const { return core_state.at(core).levels.at(level); }
+
+    size_t llc_slices() const { return slices.size(); }
+    const Cache& llc_slice(size_t i) const { return slices.at(i); }
+    uint64_t llc_hits() const;
+    uint64_t llc_misses() const;
+
+    // Counters only, on every core and cache; contents stay warm.
+    void reset_stats();
+
+private:
+    struct Request {
+        uint64_t time;          // issue time on the core's clock
+        uint64_t address;       // slice-local address
+    };
+
+    struct Core {
+        std::vector<Cache> levels;
+        CoreStats stats;
+
+        // Trace cursor.
+        TraceSource* trace = nullptr;
+        TraceChunk chunk;
+        size_t pos = 0;
+        bool done = false;
+
+        // Epochs: LLC requests of the current epoch, one queue per slice.
+        std::vector<std::vector<Request>> queued;
+    };
+
+    // What one slice found for each core during an epoch: the extra cycles
+    // (real minus assumed LLC latency) and the misses, folded into the
+    // cores' counters once the epoch closes. Kept per slice so slices
+    // running in parallel never write the same memory.
+    struct SliceTally {
+        std::vector<uint64_t> penalty;
+        std::vector<uint64_t> llc_misses;
+    };
+
+    bool next_address(Core& core, uint64_t& address);
+    // Latency of the private levels for `address`; sets `llc` when the
+    // reference missed all of them.
+    uint64_t probe_private(Core& core, uint64_t address, bool& llc);
+    size_t slice_of(uint64_t address, uint64_t& local) const;
+
+    void run_serialized();
+    void run_epochs(ThreadPool* pool);
+    void run_core_epoch(Core& core, uint64_t epoch_end);
+    void run_slice_epoch(size_t slice);
+
+    MultiCoreConfig config;
+    std::vector<Core> core_state;
+    std::vector<Cache> slices;
+    std::vector<SliceTally> tallies;
+    size_t line_size = 0;
+    unsigned slice_shift = 0;       // log2(slices)
+    uint64_t llc_hit_latency = 0;
+};
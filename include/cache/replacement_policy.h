@@ -1,9 +1,352 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
 
 enum class ReplacementPolicy : uint8_t {
     LRU,
     FIFO,
-    RANDOM
+    RANDOM,
+    TREE_PLRU,  // binary-tree pseudo-LRU, power-of-two associativity only
+    BIT_PLRU,   // MRU-bit pseudo-LRU
+    SRRIP,      // static re-reference interval prediction (2-bit)
+    BRRIP       // bimodal RRIP: distant insertion except 1 in 32 fills
 };
 
+const char* replacement_policy_name(ReplacementPolicy p);
+
+// xorshift64* step shared by the randomized policies.
+inline uint64_t xorshift64star(uint64_t& state) {
+    uint64_t x = state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    state = x;
+    return x * 2685821657736338717ULL;
+}
+
+// Replacement state, one class per policy, for all sets of one cache.
+//
+// All classes share one interface, used by BasicCache after the set index
+// is known:
+//   kKind                    the matching ReplacementPolicy enumerator
+//   kUsesRng                 whether the policy draws from the cache's RNG
+//   init(num_sets, ways)     size the state; throws std::invalid_argument
+//                            if the policy cannot handle the geometry
+//   reset()                  forget all history (cache flush)
+//   reset_set(set)           forget the history of one set
+//   on_hit(set, way)         a valid line was referenced
+//   on_fill(set, way, rng)   a line was installed in `way`
+//   victim(set, rng)         way to evict from a set with no invalid way
+//   state_arrays(f)          calls f(std::vector<T>&) on every array of
+//                            state, in a fixed order (checkpointing); the
+//                            sizes follow from init() alone
+//   validate_state(arrays)   checks candidate state before it is loaded:
+//                            arrays[i] holds the data of the i-th array of
+//                            state_arrays(), at its current size; throws
+//                            std::invalid_argument on any value the
+//                            policy could turn into a way >= ways
+// The cache fills invalid ways first (lowest way index), so victim() is only
+// asked about full sets. Each set's state occupies its own bytes, which
+// lets set-partitioned runs update disjoint sets concurrently.
+
+// True LRU, exact (same victims as timestamp LRU). Sets of up to 16 ways
+// keep their recency stack in one 64-bit word, 4 bits per position with
+// the MRU way in the low nibble, so touch and victim are a few bit
+// operations. Wider sets, up to fully associative, keep an intrusive
+// doubly-linked recency list (prev/next way per way, head and tail per
+// set), so touch and victim stay O(1) at any width.
+class LruPolicy {
+public:
+    static constexpr ReplacementPolicy kKind = ReplacementPolicy::LRU;
+    static constexpr bool kUsesRng = false;
+
+    void init(size_t num_sets, size_t ways);
+    void reset();
+    void reset_set(size_t set) {
+        if (packed) {
+            stack[set] = kIdentity;
+            return;
+        }
+        // Way 0 at the MRU end, the last way at the LRU end.
+        uint32_t* p = &prev[set * ways];
+        uint32_t* n = &next[set * ways];
+        for (size_t w = 0; w < ways; w++) {
+            p[w] = w == 0 ? kNil : static_cast<uint32_t>(w - 1);
+            n[w] = w + 1 == ways ? kNil : static_cast<uint32_t>(w + 1);
+        }
+        head[set] = 0;
+        tail[set] = static_cast<uint32_t>(ways - 1);
+    }
+
+    void on_hit(size_t set, size_t way) { promote(set, way); }
+    void on_fill(size_t set, size_t way, uint64_t&) { promote(set, way); }
+
+    size_t victim(size_t set, uint64_t&) const {
+        if (packed) return static_cast<size_t>((stack[set] >> (4 * (ways - 1))) & 0xf);
+        return tail[set];
+    }
+
+    template <typename F> void state_arrays(F&& f) { f(stack); f(prev); f(next); f(head); f(tail); }
+    template <typename F> void state_arrays(F&& f) const { f(stack); f(prev); f(next); f(head); f(tail); }
+    // Packed stacks must permute the set's ways in their low nibbles; lists
+    // must link every way exactly once, from head to tail.
+    void validate_state(const std::vector<const void*>& arrays) const;
+
+private:
+    static constexpr size_t kPackedWays = 16;
+    static constexpr uint64_t kIdentity = 0xfedcba9876543210ULL;  // way w at position w
+    static constexpr uint32_t kNil = 0xffffffffu;
+
+    void promote(size_t set, size_t way) {
+        if (packed) {
+            // Find the nibble holding `way` (lowest zero nibble of the XOR),
+            // then move it to position 0 and shift the more recent ones up.
+            uint64_t& s = stack[set];
+            const uint64_t x = s ^ (static_cast<uint64_t>(way) * 0x1111111111111111ULL);
+            const uint64_t zero = (x - 0x1111111111111111ULL) & ~x & 0x8888888888888888ULL;
+            const unsigned pos = static_cast<unsigned>(__builtin_ctzll(zero)) & ~3u;
+            const uint64_t upto = (2ULL << (pos + 3)) - 1;   // nibbles 0..pos
+            s = (s & ~upto) | ((s & (upto >> 4)) << 4) | way;
+            return;
+        }
+        const uint32_t w = static_cast<uint32_t>(way);
+        uint32_t& h = head[set];
+        if (h == w) return;
+        uint32_t* p = &prev[set * ways];
+        uint32_t* n = &next[set * ways];
+        // Not the head, so p[w] is a way; unlink, then push at the MRU end.
+        n[p[w]] = n[w];
+        if (n[w] != kNil) p[n[w]] = p[w];
+        else tail[set] = p[w];
+        p[w] = kNil;
+        n[w] = h;
+        p[h] = w;
+        h = w;
+    }
+
+    size_t ways = 0;
+    bool packed = false;
+    std::vector<uint64_t> stack;    // ways <= kPackedWays
+    std::vector<uint32_t> prev;     // wider sets: recency list links per way
+    std::vector<uint32_t> next;
+    std::vector<uint32_t> head;     // MRU way per set
+    std::vector<uint32_t> tail;     // LRU way per set
+};
+
+// FIFO as a per-set round-robin pointer. Since fills go to invalid ways in
+// way order, the next way after the last fill is always the oldest line.
+class FifoPolicy {
+public:
+    static constexpr ReplacementPolicy kKind = ReplacementPolicy::FIFO;
+    static constexpr bool kUsesRng = false;
+
+    void init(size_t num_sets, size_t ways);
+    void reset();
+    void reset_set(size_t set) { next[set] = 0; }
+
+    void on_hit(size_t, size_t) {}
+    void on_fill(size_t set, size_t way, uint64_t&) {
+        next[set] = static_cast<uint32_t>(way + 1 == ways ? 0 : way + 1);
+    }
+    size_t victim(size_t set, uint64_t&) const { return next[set]; }
+
+    template <typename F> void state_arrays(F&& f) { f(next); }
+    template <typename F> void state_arrays(F&& f) const { f(next); }
+    void validate_state(const std::vector<const void*>& arrays) const;
+
+private:
+    size_t ways = 0;
+    std::vector<uint32_t> next;
+};
+
+// Uniform random victim; no per-set state.
+class RandomPolicy {
+public:
+    static constexpr ReplacementPolicy kKind = ReplacementPolicy::RANDOM;
+    static constexpr bool kUsesRng = true;
+
+    void init(size_t, size_t ways) { this->ways = ways; }
+    void reset() {}
+    void reset_set(size_t) {}
+
+    void on_hit(size_t, size_t) {}
+    void on_fill(size_t, size_t, uint64_t&) {}
+    size_t victim(size_t, uint64_t& rng) const {
+        return static_cast<size_t>(xorshift64star(rng) % ways);
+    }
+
+    template <typename F> void state_arrays(F&&) const {}
+    void validate_state(const std::vector<const void*>&) const {}
+
+private:
+    size_t ways = 0;
+};
+
+// Per-set bit rows of a fixed width, each padded to whole 64-bit words.
+class SetBits {
+public:
+    void init(size_t num_sets, size_t bits_per_set) {
+        words = (bits_per_set + 63) / 64;
+        bits.assign(num_sets * words, 0);
+    }
+    void clear() { std::fill(bits.begin(), bits.end(), 0); }
+    void clear_row(size_t set) { std::fill(row(set), row(set) + words, 0); }
+
+    uint64_t* row(size_t set) { return &bits[set * words]; }
+    const uint64_t* row(size_t set) const { return &bits[set * words]; }
+    size_t words_per_set() const { return words; }
+
+    std::vector<uint64_t>& storage() { return bits; }
+    const std::vector<uint64_t>& storage() const { return bits; }
+
+    static bool get(const uint64_t* r, size_t i) { return (r[i >> 6] >> (i & 63)) & 1; }
+    static void put(uint64_t* r, size_t i, bool v) {
+        const uint64_t m = 1ULL << (i & 63);
+        r[i >> 6] = v ? (r[i >> 6] | m) : (r[i >> 6] & ~m);
+    }
+
+private:
+    size_t words = 0;
+    std::vector<uint64_t> bits;
+};
+
+// Binary-tree PLRU: ways - 1 node bits per set. Node n (1-based heap order)
+// points toward the subtree to evict from; 0 = left, 1 = right.
+class TreePlruPolicy {
+public:
+    static constexpr ReplacementPolicy kKind = ReplacementPolicy::TREE_PLRU;
+    static constexpr bool kUsesRng = false;
+
+    void init(size_t num_sets, size_t ways);
+    void reset() { node.clear(); }
+    void reset_set(size_t set) { node.clear_row(set); }
+
+    void on_hit(size_t set, size_t way) { point_away(set, way); }
+    void on_fill(size_t set, size_t way, uint64_t&) { point_away(set, way); }
+
+    size_t victim(size_t set, uint64_t&) const {
+        const uint64_t* r = node.row(set);
+        size_t n = 1;
+        while (n < ways) n = 2 * n + SetBits::get(r, n);
+        return n - ways;
+    }
+
+    template <typename F> void state_arrays(F&& f) { f(node.storage()); }
+    template <typename F> void state_arrays(F&& f) const { f(node.storage()); }
+    // Any node bits lead to a leaf, so every state is valid.
+    void validate_state(const std::vector<const void*>&) const {}
+
+private:
+    void point_away(size_t set, size_t way) {
+        uint64_t* r = node.row(set);
+        for (size_t n = way + ways; n > 1; n >>= 1) {
+            SetBits::put(r, n >> 1, (n & 1) == 0);
+        }
+    }
+
+    size_t ways = 0;
+    SetBits node;
+};
+
+// MRU-bit PLRU: one bit per way, set on reference. When the last clear bit
+// would be set, all others are cleared. Victim is the lowest clear way.
+class BitPlruPolicy {
+public:
+    static constexpr ReplacementPolicy kKind = ReplacementPolicy::BIT_PLRU;
+    static constexpr bool kUsesRng = false;
+
+    void init(size_t num_sets, size_t ways);
+    void reset();
+    void reset_set(size_t set) {
+        mru.clear_row(set);
+        mru.row(set)[mru.words_per_set() - 1] = ~last_word_mask;
+    }
+
+    void on_hit(size_t set, size_t way) { mark(set, way); }
+    void on_fill(size_t set, size_t way, uint64_t&) { mark(set, way); }
+
+    size_t victim(size_t set, uint64_t&) const {
+        const uint64_t* r = mru.row(set);
+        for (size_t i = 0; i < mru.words_per_set(); i++) {
+            if (~r[i]) return i * 64 + static_cast<size_t>(__builtin_ctzll(~r[i]));
+        }
+        return 0;
+    }
+
+    template <typename F> void state_arrays(F&& f) { f(mru.storage()); }
+    template <typename F> void state_arrays(F&& f) const { f(mru.storage()); }
+    // Padding bits past the last way must read as referenced.
+    void validate_state(const std::vector<const void*>& arrays) const;
+
+private:
+    void mark(size_t set, size_t way);
+
+    size_t ways = 0;
+    size_t num_sets = 0;
+    uint64_t last_word_mask = 0;    // valid bits of the final word in a row
+    SetBits mru;
+};
+
+// RRIP with 2-bit re-reference prediction values (Jaleel et al., ISCA'10).
+// Hits promote to 0; the victim is the first way predicted distant (3),
+// aging the whole set until one is. SRRIP inserts at 2 ("long"); BRRIP
+// inserts at 3 except for one fill in 32, which resists thrashing.
+template <bool Bimodal>
+class RripPolicy {
+public:
+    static constexpr ReplacementPolicy kKind = Bimodal ? ReplacementPolicy::BRRIP : ReplacementPolicy::SRRIP;
+    static constexpr bool kUsesRng = Bimodal;
+
+    static constexpr uint8_t kDistant = 3;
+
+    void init(size_t num_sets, size_t ways) {
+        this->ways = ways;
+        rrpv.assign(num_sets * ways, kDistant);
+    }
+    void reset() { std::fill(rrpv.begin(), rrpv.end(), kDistant); }
+    void reset_set(size_t set) { std::fill(&rrpv[set * ways], &rrpv[set * ways] + ways, kDistant); }
+
+    void on_hit(size_t set, size_t way) { rrpv[set * ways + way] = 0; }
+
+    void on_fill(size_t set, size_t way, uint64_t& rng) {
+        uint8_t v = kDistant - 1;
+        if (Bimodal && (xorshift64star(rng) & 31) != 0) v = kDistant;
+        rrpv[set * ways + way] = v;
+    }
+
+    size_t victim(size_t set, uint64_t&) {
+        uint8_t* r = &rrpv[set * ways];
+        uint8_t oldest = 0;
+        for (size_t w = 0; w < ways; w++) {
+            if (r[w] == kDistant) return w;
+            if (r[w] > oldest) oldest = r[w];
+        }
+        const uint8_t age = kDistant - oldest;
+        size_t v = ways;
+        for (size_t w = 0; w < ways; w++) {
+            r[w] = static_cast<uint8_t>(r[w] + age);
+            if (v == ways && r[w] == kDistant) v = w;
+        }
+        return v;
+    }
+
+    template <typename F> void state_arrays(F&& f) { f(rrpv); }
+    template <typename F> void state_arrays(F&& f) const { f(rrpv); }
+    // Aging assumes every value is at most kDistant.
+    void validate_state(const std::vector<const void*>& arrays) const {
+        const uint8_t* r = static_cast<const uint8_t*>(arrays.at(0));
+        for (size_t i = 0; i < rrpv.size(); i++) {
+            if (r[i] > kDistant) throw std::invalid_argument("RRIP state value out of range");
+        }
+    }
+
+private:
+    size_t ways = 0;
+    std::vector<uint8_t> rrpv;
+};
+
+using SrripPolicy = RripPolicy<false>;
+using BrripPolicy = RripPolicy<true>;
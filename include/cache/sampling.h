@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "cache/timing.h"
+
+class Cache;
+class TraceSource;
+
+// Systematic interval sampling in the style of SMARTS (Wunderlich et al.,
+// ISCA'03). The reference stream is cut into periods of `period` refs; the
+// last `window` refs of each period are simulated in detail and measured,
+// the ones before only functionally warm the cache (Cache::warm: tags and
+// replacement state, no stats or timing). Since warming keeps the full
+// cache state current, every window starts from the state a complete
+// simulation would have, so per-window results carry no cold-start bias.
+struct SamplingConfig {
+    uint64_t period = 1000000;
+    uint64_t window = 10000;
+};
+
+struct SampleWindow {
+    uint64_t start = 0;             // index of the window's first reference
+    FunctionalResult result;
+    double amat = 0.0;
+};
+
+struct SamplingResult {
+    std::vector<SampleWindow> windows;
+    uint64_t total_refs = 0;        // references seen, warmed or measured
+    uint64_t measured_refs = 0;
+
+    // Mean over complete windows, and the half-width of its confidence
+    // interval at the requested z (with finite-population correction).
+    // A partial trailing window is reported but left out of the aggregate.
+    double miss_rate = 0.0;
+    double miss_rate_ci = 0.0;
+    double amat = 0.0;
+    double amat_ci = 0.0;
+    double miss_rate_cv = 0.0;      // coefficient of variation across windows
+};
+
+// Drives one cache through a sampled run. The controller owns the cache's
+// counters while it runs: each window starts with Cache::reset_stats(),
+// which keeps the warm contents.
+class SamplingController {
+public:
+    // Throws std::invalid_argument unless 0 < window <= period.
+    SamplingController(Cache& cache, SamplingConfig config);
+
+    // Consumes the next `count` references of the stream.
+    void access_batch(const uint64_t* addresses, size_t count);
+
+    // Drains `source` through access_batch.
+    void run(TraceSource& source);
+
+    // Windows so far and their aggregate; z = 1.96 gives 95% intervals.
+    SamplingResult result(double z = 1.96) const;
+
+private:
+    void close_window();
+
+    Cache& cache;
+    SamplingConfig config;
+    uint64_t position = 0;          // references consumed so far
+    uint64_t window_start = 0;
+    bool in_window = false;
+    std::vector<SampleWindow> windows;
+};
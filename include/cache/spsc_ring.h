@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// Bounded single-producer / single-consumer queue. One thread may call
+// try_push, one other thread try_pop; neither ever takes a lock or
+// allocates. Head and tail live on separate cache lines, and each side
+// caches the other's index so the shared line is only re-read when the
+// ring looks full (producer) or empty (consumer).
+template <typename T>
+class SpscRing {
+public:
+    // Capacity is rounded up to a power of two; throws std::invalid_argument
+    // if it is 0.
+    explicit SpscRing(size_t capacity) {
+        if (capacity == 0) throw std::invalid_argument("ring capacity must be > 0");
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots.resize(n);
+        mask = n - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // Producer side. Returns false, leaving `v` untouched, if the ring is full.
+    bool try_push(const T& v) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache == slots.size()) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache == slots.size()) return false;
+        }
+        slots[t & mask] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool try_pop(T& out) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) return false;
+        }
+        out = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side; exact only when the other side is idle.
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t kLine = 64;
+
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    alignas(kLine) std::atomic<size_t> head{0};     // next slot to pop
+    size_t tail_cache = 0;                          // consumer's view of tail
+    alignas(kLine) std::atomic<size_t> tail{0};     // next slot to push
+    size_t head_cache = 0;                          // producer's view of head
+};
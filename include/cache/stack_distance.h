@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "cache/fast_div.h"
+
+// Miss-ratio curve of an LRU cache with a fixed line size and set count,
+// as a function of associativity. Built from per-set stack distances: a
+// reuse at distance d (d distinct other lines touched in the same set since
+// the previous reference) hits in every cache with more than d ways.
+struct MissRatioCurve {
+    size_t line_size = 0;
+    size_t num_sets = 0;
+
+    uint64_t accesses = 0;
+    uint64_t cold_misses = 0;                 // first reference to a line
+    std::vector<uint64_t> distance_counts;    // reuses at stack distance d
+    uint64_t beyond = 0;                      // reuses at distance >= distance_counts.size()
+
+    // Largest associativity the curve answers exactly.
+    size_t max_assoc() const { return distance_counts.size(); }
+
+    uint64_t hits(size_t assoc) const;
+    uint64_t misses(size_t assoc) const { return accesses - hits(assoc); }
+    double   miss_rate(size_t assoc) const;
+
+    size_t capacity_bytes(size_t assoc) const { return assoc * num_sets * line_size; }
+};
+
+// Single-pass Mattson stack-distance analysis for LRU.
+//
+// One pass over a trace yields the exact hit/miss counts of every LRU cache
+// with the given line size, for each requested set count and every
+// associativity up to max_assoc. Per set, the time of each line's latest
+// reference is marked in a Fenwick tree; the stack distance of a reuse is
+// the number of marks after the line's previous mark, so each reference
+// costs O(log n) per set count. Slots are compacted when a set's tree fills,
+// which bounds memory by the trace footprint rather than its length.
+class StackDistanceAnalyzer {
+public:
+    StackDistanceAnalyzer(size_t line_size,
+                          std::vector<size_t> set_counts,
+                          size_t max_assoc);
+
+    void access(uint64_t address);
+    void access_batch(const uint64_t* addresses, size_t count);
+
+    // One curve per set count, in constructor order.
+    std::vector<MissRatioCurve> curves() const;
+
+private:
+    struct SetStack {
+        std::vector<uint32_t> tree;    // Fenwick tree over slots (1-based)
+        std::vector<uint32_t> owner;   // line id marked at each slot, or kNoLine
+        uint32_t next_slot = 0;
+        uint32_t live = 0;             // marked slots
+    };
+
+    struct Geometry {
+        size_t num_sets = 0;
+        FastDivider set_div;
+        std::vector<SetStack> sets;
+        std::vector<uint32_t> slot_of;  // per line id: current slot in its set
+        uint64_t cold = 0;
+        uint64_t beyond = 0;
+        std::vector<uint64_t> hist;
+    };
+
+    static constexpr uint32_t kNoLine = 0xffffffffu;
+
+    static void fenwick_add(std::vector<uint32_t>& tree, uint32_t slot, int32_t delta);
+    static uint32_t fenwick_prefix(const std::vector<uint32_t>& tree, uint32_t slot);
+
+    void touch(Geometry& g, uint64_t line, uint32_t id, bool first_touch);
+    void compact(Geometry& g, SetStack& s);
+
+    size_t line_size;
+    FastDivider line_div;
+    size_t max_assoc;
+    uint64_t accesses = 0;
+
+    std::unordered_map<uint64_t, uint32_t> line_ids;
+    std::vector<Geometry> geometries;
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "cache/trace_source.h"
+
+// Generated address patterns as TraceSources. Each yields reads only, in
+// chunks of up to kSyntheticChunkRecords addresses generated into a buffer
+// the source owns; a rewound source repeats exactly the same references.
+constexpr size_t kSyntheticChunkRecords = 4096;
+
+// Common chunking for the patterns below: a fixed number of records, each
+// produced by fill() in order.
+class SyntheticTraceSource : public TraceSource {
+public:
+    bool next(TraceChunk& chunk) override;
+    void rewind() override;
+
+    uint64_t record_count() const { return length; }
+
+protected:
+    explicit SyntheticTraceSource(uint64_t length);
+
+    // Writes the next `n` addresses; called for consecutive runs of the
+    // trace, starting over after restart().
+    virtual void fill(uint64_t* out, size_t n) = 0;
+    virtual void restart() = 0;
+
+private:
+    uint64_t length;
+    uint64_t position = 0;
+    std::vector<uint64_t> buf;
+};
+
+// Streaming sequential: 0, step, 2*step, ... below `bytes`. Strong spatial
+// locality, no temporal reuse. Throws std::invalid_argument if step is 0.
+class StreamTraceSource final : public SyntheticTraceSource {
+public:
+    StreamTraceSource(uint64_t bytes, uint64_t step_bytes);
+
+private:
+    void fill(uint64_t* out, size_t n) override;
+    void restart() override { addr = 0; }
+
+    uint64_t step;
+    uint64_t addr = 0;
+};
+
+// The stream over a working set, repeated `passes` times: shows capacity
+// effects. Throws std::invalid_argument if step is 0.
+class ReuseTraceSource final : public SyntheticTraceSource {
+public:
+    ReuseTraceSource(uint64_t working_set_bytes, uint64_t step_bytes, uint64_t passes);
+
+private:
+    void fill(uint64_t* out, size_t n) override;
+    void restart() override { addr = 0; }
+
+    uint64_t working_set;
+    uint64_t step;
+    uint64_t addr = 0;
+};
+
+// Round-robin over `hot_lines` addresses spaced `spacing` bytes apart, which
+// map to one set under typical indexing when spacing is the cache size:
+// shows associativity and policy differences. Throws std::invalid_argument
+// if hot_lines is 0.
+class ConflictTraceSource final : public SyntheticTraceSource {
+public:
+    ConflictTraceSource(uint64_t spacing, uint64_t hot_lines, uint64_t accesses);
+
+private:
+    void fill(uint64_t* out, size_t n) override;
+    void restart() override { hot = 0; }
+
+    uint64_t spacing;
+    uint64_t hot_lines;
+    uint64_t hot = 0;
+};
+
+// Stride walk that wraps within a working set: spatial locality and set
+// conflicts depending on the stride. Throws std::invalid_argument if the
+// working set is 0.
+class StrideTraceSource final : public SyntheticTraceSource {
+public:
+    StrideTraceSource(uint64_t working_set_bytes, uint64_t stride_bytes, uint64_t accesses);
+
+private:
+    void fill(uint64_t* out, size_t n) override;
+    void restart() override { addr = 0; }
+
+    uint64_t working_set;
+    uint64_t stride;
+    uint64_t addr = 0;
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Compares a probe tag against up to 64 contiguous ways of one set.
+// Returns a bitmask with bit w set when tags[w] == tag. Valid state is not
+// consulted; callers pass only the ways that hold valid lines.
+using TagMatchFn = uint64_t (*)(const uint64_t* tags, size_t ways, uint64_t tag);
+
+// Sets with fewer ways than this are scanned inline; the call overhead of a
+// vector kernel does not pay off for them.
+constexpr size_t kTagMatchMinWays = 8;
+
+uint64_t tag_match_scalar(const uint64_t* tags, size_t ways, uint64_t tag);
+
+// Best available kernel for the host CPU (AVX-512, AVX2, NEON or scalar),
+// resolved once on first use.
+TagMatchFn select_tag_match();
+
+// Name of the kernel select_tag_match() returns, for diagnostics.
+const char* tag_match_isa_name();
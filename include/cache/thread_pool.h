@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing thread pool.
+//
+// Each worker owns a deque: it pops its own work from the back and, when
+// empty, steals from the front of the other workers' deques. Tasks submitted
+// from outside the pool are spread round-robin; tasks submitted from inside a
+// worker go to that worker's own deque.
+class ThreadPool {
+public:
+    // num_threads == 0 sizes the pool to the machine.
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    template <typename F>
+    auto submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        std::future<R> result = task->get_future();
+        enqueue([task] { (*task)(); });
+        return result;
+    }
+
+    // Runs fn(i) for every i in [0, n) and returns when all calls finished.
+    // The calling thread takes part, so this is safe to use from a worker.
+    void parallel_for(size_t n, const std::function<void(size_t)>& fn);
+
+    static size_t default_thread_count();
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void enqueue(Task task);
+    bool try_pop(size_t self, Task& task);
+    bool try_steal(size_t self, Task& task);
+    void worker_loop(size_t self);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> next_worker{0};
+    bool stopping = false;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+#include "cache/types.h"
+
+// Hit/miss outcome of a functional simulation. Independent of latencies,
+// so one functional pass can be re-timed for any number of TimingParams.
+struct FunctionalResult {
+    size_t   line_size = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    // Filled when miss classification ran (see BasicCache).
+    bool        classified = false;
+    MissClasses classes{};
+
+    // False when set sampling dropped every reference, so no sampled set
+    // saw one and there is nothing to extrapolate from; the miss rate (and
+    // with it AMAT) is then NaN rather than a confident 0.
+    bool estimable = true;
+
+    uint64_t accesses() const { return hits + misses; }
+
+    double miss_rate() const {
+        if (!estimable) return std::numeric_limits<double>::quiet_NaN();
+        const uint64_t total = accesses();
+        if (total == 0) return 0.0;
+        return static_cast<double>(misses) / static_cast<double>(total);
+    }
+};
+
+// Latency parameters of one cache level.
+struct TimingParams {
+    size_t hit_latency = 1;
+    size_t miss_penalty = 0;        // fixed penalty, used unless use_mem_timing
+    MemoryTiming mem_timing{};
+    bool use_mem_timing = false;
+
+    // Cycles to service one miss for the given line size.
+    size_t miss_penalty_cycles(size_t line_size) const {
+        if (use_mem_timing) return mem_timing.miss_service_cycles(line_size);
+        return miss_penalty;
+    }
+};
+
+struct TimingResult {
+    double   amat = 0.0;            // average memory access time (cycles)
+    uint64_t total_cycles = 0;      // sum of per-access latencies
+};
+
+// Timing post-pass over a functional result.
+inline TimingResult evaluate_timing(const FunctionalResult& f, const TimingParams& t) {
+    const size_t penalty = t.miss_penalty_cycles(f.line_size);
+    TimingResult r;
+    r.amat = static_cast<double>(t.hit_latency) + f.miss_rate() * static_cast<double>(penalty);
+    r.total_cycles = f.accesses() * t.hit_latency + f.misses * penalty;
+    return r;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "cache/mapped_file.h"
+#include "cache/trace_source.h"
+
+// -----------------------------
+// Compressed trace format (.cmz)
+// -----------------------------
+//
+// All integers are little-endian.
+//
+// File header, 32 bytes:
+//   offset  size  field
+//        0     8  magic          "CMZTRACE"
+//        8     4  version        1
+//       12     4  chunk_records  records per chunk (the last may be short)
+//       16     8  record_count   total records in the file
+//       24     8  reserved       zero
+//
+// Followed by a sequence of chunks. Every chunk is self-contained, so a
+// reader can locate chunks by walking the headers and decode them in any
+// order (or in parallel).
+//
+// Chunk header, 24 bytes:
+//        0     4  magic          "CMZC"
+//        4     4  count          records in this chunk
+//        8     8  first_address  absolute address of record 0
+//       16     4  address_bytes  size of the encoded address stream
+//       20     4  type_bytes     size of the type bitmap (0 = all reads)
+//
+// Address stream: for records 1..count-1, the difference from the previous
+// address, zig-zag mapped to unsigned and written as an LEB128 varint.
+// Type bitmap: bit i (LSB first) set when record i is a write.
+// The chunk payload is padded to a multiple of 8 bytes.
+
+struct CompressedTraceHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t chunk_records;
+    uint64_t record_count;
+    uint64_t reserved;
+};
+static_assert(sizeof(CompressedTraceHeader) == 32, "compressed header must be 32 bytes");
+
+struct CompressedChunkHeader {
+    char     magic[4];
+    uint32_t count;
+    uint64_t first_address;
+    uint32_t address_bytes;
+    uint32_t type_bytes;
+};
+static_assert(sizeof(CompressedChunkHeader) == 24, "chunk header must be 24 bytes");
+
+constexpr uint32_t kCompressedTraceVersion = 1;
+constexpr uint32_t kCompressedDefaultChunkRecords = 64 * 1024;
+
+class CompressedTraceWriter {
+public:
+    explicit CompressedTraceWriter(const std::string& path,
+                                   uint32_t chunk_records = kCompressedDefaultChunkRecords);
+    ~CompressedTraceWriter();
+
+    void append(uint64_t address, AccessType type = AccessType::Read);
+
+    // Encodes the last chunk and finalizes the header. Called by the
+    // destructor if not called explicitly.
+    void close();
+
+private:
+    void flush_chunk();
+
+    std::ofstream out;
+    uint32_t chunk_records;
+    uint64_t record_count = 0;
+    bool closed = false;
+
+    std::vector<uint64_t> addresses;
+    std::vector<uint8_t>  types;
+    std::vector<uint8_t>  encoded;
+};
+
+// Memory-maps a .cmz file and decodes it chunk by chunk. The chunk index is
+// built once at open; decode_chunk() is const and may run concurrently from
+// several threads with caller-owned buffers.
+class CompressedTraceReader : public TraceSource {
+public:
+    explicit CompressedTraceReader(const std::string& path);
+
+    bool next(TraceChunk& chunk) override;
+    void rewind() override { next_chunk = 0; }
+
+    uint64_t record_count() const { return header.record_count; }
+    size_t   chunk_count() const { return chunk_offsets.size(); }
+
+    // Decodes chunk `i` into `addresses` / `types`, resizing them to fit.
+    void decode_chunk(size_t i,
+                      std::vector<uint64_t>& addresses,
+                      std::vector<uint8_t>& types) const;
+
+private:
+    MappedFile file;
+    CompressedTraceHeader header{};
+    std::vector<size_t> chunk_offsets;
+    size_t next_chunk = 0;
+
+    std::vector<uint64_t> addr_buf;
+    std::vector<uint8_t>  type_buf;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "cache/mapped_file.h"
+#include "cache/trace_source.h"
+
+// -----------------------------
+// Binary trace file format (.cmt)
+// -----------------------------
+//
+// All integers are little-endian.
+//
+// Header, 64 bytes:
+//   offset  size  field
+//        0     8  magic          "CMTRACE1"
+//        8     4  version        1
+//       12     4  flags          bit 0: PC column present
+//                                bit 1: thread-id column present
+//       16     8  record_count   total records in the file
+//       24     4  block_records  records per block (the last may be short)
+//       28    36  reserved       zero
+//
+// The header is followed by ceil(record_count / block_records) blocks. A
+// block of n records stores each field as its own column, every column
+// starting on an 8-byte boundary:
+//   uint64_t address[n]
+//   uint8_t  type[n]          AccessType: 0 = read, 1 = write
+//   uint64_t pc[n]            if flags bit 0
+//   uint32_t thread_id[n]     if flags bit 1
+//
+// Records are fixed width, so block offsets follow from the header alone,
+// and the address column of a mapped block can be passed straight to
+// Cache::access_batch without copying.
+
+struct TraceFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t record_count;
+    uint32_t block_records;
+    uint8_t  reserved[36];
+};
+static_assert(sizeof(TraceFileHeader) == 64, "trace header must be 64 bytes");
+
+constexpr uint32_t kTraceFileVersion = 1;
+constexpr uint32_t kTraceHasPc = 1u << 0;
+constexpr uint32_t kTraceHasThreadId = 1u << 1;
+constexpr uint32_t kTraceDefaultBlockRecords = 64 * 1024;
+
+// Byte size of one block of `n` records for the given flags.
+size_t trace_block_bytes(uint32_t flags, size_t n);
+
+// Streams records into a .cmt file, one block at a time.
+class TraceFileWriter {
+public:
+    TraceFileWriter(const std::string& path,
+                    uint32_t flags = 0,
+                    uint32_t block_records = kTraceDefaultBlockRecords);
+    ~TraceFileWriter();
+
+    void append(uint64_t address,
+                AccessType type = AccessType::Read,
+                uint64_t pc = 0,
+                uint32_t thread_id = 0);
+
+    // Flushes the last block and finalizes the header. Called by the
+    // destructor if not called explicitly.
+    void close();
+
+private:
+    void flush_block();
+
+    std::ofstream out;
+    uint32_t flags;
+    uint32_t block_records;
+    uint64_t record_count = 0;
+    bool closed = false;
+
+    std::vector<uint64_t> addresses;
+    std::vector<uint8_t>  types;
+    std::vector<uint64_t> pcs;
+    std::vector<uint32_t> thread_ids;
+};
+
+// Memory-mapped, zero-copy reader for .cmt files (POSIX mmap). Each call to
+// next() yields one block whose columns point directly into the mapping.
+class MappedTraceReader : public TraceSource {
+public:
+    explicit MappedTraceReader(const std::string& path);
+
+    bool next(TraceChunk& chunk) override;
+    void rewind() override { next_block = 0; }
+
+    uint64_t record_count() const { return header.record_count; }
+    size_t   block_count() const { return num_blocks; }
+    bool     has_pc() const { return (header.flags & kTraceHasPc) != 0; }
+    bool     has_thread_id() const { return (header.flags & kTraceHasThreadId) != 0; }
+
+    // Random access to block `i`, for readers that split work by block.
+    TraceChunk block(size_t i) const;
+
+private:
+    MappedFile file;
+    TraceFileHeader header{};
+    size_t num_blocks = 0;
+    size_t next_block = 0;
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cache/spsc_ring.h"
+#include "cache/trace_source.h"
+
+// Runs another TraceSource on a background thread, up to `depth` chunks
+// ahead of the consumer, so reading, page-faulting, decompressing or
+// generating the next chunks overlaps with simulating the current one.
+// Chunks are copied into preallocated slots that travel between the two
+// threads through lock-free rings (SpscRing); neither side allocates once
+// the slots have grown to the inner source's chunk size. A side that finds
+// its ring empty yields for a short, bounded spin and then blocks on a
+// condition variable, so a stalled side never holds a core that the
+// simulation threads could use; the other side only takes the mutex to
+// notify when it sees a waiter.
+//
+// The inner source must outlive this one and must not be used directly
+// while this one exists. An exception thrown by the inner source is
+// rethrown by the next() call that reaches the point where it failed.
+class PrefetchingTraceSource : public TraceSource {
+public:
+    // Throws std::invalid_argument if depth is 0.
+    explicit PrefetchingTraceSource(TraceSource& inner, size_t depth = 4);
+    ~PrefetchingTraceSource() override;
+
+    PrefetchingTraceSource(const PrefetchingTraceSource&) = delete;
+    PrefetchingTraceSource& operator=(const PrefetchingTraceSource&) = delete;
+
+    // The chunk stays valid until the following next() or rewind().
+    bool next(TraceChunk& chunk) override;
+
+    // Stops the producer, rewinds the inner source and starts over.
+    void rewind() override;
+
+    // Calls of next() that found no chunk ready (the simulation waited on
+    // the source) and chunks for which the producer found no free slot (the
+    // source was `depth` chunks ahead).
+    uint64_t consumer_waits() const { return cwaits; }
+    uint64_t producer_waits() const { return pwaits.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t kNoSlot = 0xffffffffu;
+    static constexpr uint32_t kEnd = 0xfffffffeu;   // end of trace (or error)
+    static constexpr int kSpinRounds = 64;          // yields before blocking
+
+    struct Slot {
+        std::vector<uint64_t> addresses;
+        std::vector<uint8_t>  types;
+        std::vector<uint64_t> pcs;
+        std::vector<uint32_t> thread_ids;
+        TraceChunk chunk;       // points into the vectors above
+    };
+
+    void start();
+    void stop();
+    void produce();
+
+    // Spins, then blocks until ready() (which tries to take from a ring)
+    // returns true; `waiting` advertises the blocked side to wake().
+    template <typename Ready>
+    void wait_until(std::atomic<bool>& waiting, Ready ready);
+    // Called after handing something over: wakes the other side if blocked.
+    void wake(const std::atomic<bool>& waiting);
+
+    TraceSource& inner;
+    std::vector<Slot> slots;
+    SpscRing<uint32_t> free_slots;      // consumer -> producer
+    SpscRing<uint32_t> full_slots;      // producer -> consumer, then kEnd
+    uint32_t held = kNoSlot;            // slot of the chunk last returned
+    bool ended = false;
+    uint64_t cwaits = 0;
+    std::atomic<uint64_t> pwaits{0};
+
+    std::atomic<bool> stopping{false};
+    std::exception_ptr error;           // set by the producer before kEnd
+    std::thread thread;
+
+    std::mutex mutex;                   // guards only the blocking waits
+    std::condition_variable wakeup;
+    std::atomic<bool> consumer_waiting{false};
+    std::atomic<bool> producer_waiting{false};
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "cache/types.h"
+
+class Cache;
+
+enum class AccessType : uint8_t {
+    Read = 0,
+    Write = 1
+};
+
+// A run of consecutive trace records. Columns are parallel arrays of
+// `count` entries; optional columns are null when the trace lacks them.
+// The pointers stay valid until the next call on the source that produced
+// the chunk.
+struct TraceChunk {
+    const uint64_t* addresses = nullptr;
+    const uint8_t*  types = nullptr;       // AccessType values (0 = read, 1 = write)
+    const uint64_t* pcs = nullptr;
+    const uint32_t* thread_ids = nullptr;
+    size_t count = 0;
+};
+
+// Producer of address traces, consumed chunk by chunk.
+class TraceSource {
+public:
+    virtual ~TraceSource() = default;
+
+    // Fills `chunk` with the next run of records. Returns false (and an empty
+    // chunk) once the trace is exhausted.
+    virtual bool next(TraceChunk& chunk) = 0;
+
+    // Restarts the trace from its first record.
+    virtual void rewind() = 0;
+};
+
+// Opens a .cmt or .cmz trace file, chosen by its magic bytes.
+std::unique_ptr<TraceSource> open_trace_file(const std::string& path);
+
+// Drains `source` into `cache` through Cache::access_batch.
+BatchStats simulate_trace(Cache& cache, TraceSource& source);
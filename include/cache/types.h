@@ -1,5 +1,6 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
 
 struct MemoryTiming {
     // Cycles to first byte (queuing + DRAM + controller + interconnect, etc.)
@@ -20,3 +21,56 @@ struct MemoryTiming {
         return fixed_latency_cycles + transfer_cycles(line_size_bytes);
     }
 };
+
+// Per-reference outcome reported by Cache::access_batch.
+struct AccessResult {
+    uint64_t latency = 0;
+    bool hit = false;
+};
+
+// Aggregate outcome of one Cache::access_batch call.
+struct BatchStats {
+    uint64_t accesses = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t skipped = 0;         // dropped by set sampling, neither hit nor miss
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t total_latency = 0;   // sum of per-access latencies (cycles)
+
+    BatchStats& operator+=(const BatchStats& o) {
+        accesses += o.accesses;
+        hits += o.hits;
+        misses += o.misses;
+        skipped += o.skipped;
+        reads += o.reads;
+        writes += o.writes;
+        total_latency += o.total_latency;
+        return *this;
+    }
+};
+
+// Miss-rate estimate of a set-sampled cache (Cache::set_sample_estimate).
+// Sampled sets are treated as clusters of a ratio estimator; the interval
+// includes the finite-population correction for the sets not sampled.
+struct SetSampleEstimate {
+    size_t   sampled_sets = 0;
+    size_t   total_sets = 0;
+    uint64_t simulated = 0;         // references that reached a sampled set
+    uint64_t skipped = 0;           // references dropped before tag lookup
+    // NaN and infinity when every reference was skipped: no sampled set
+    // was touched, so the trace is not estimable at this ratio.
+    double   miss_rate = 0.0;
+    double   ci_half_width = 0.0;   // at the requested z; 0 when exact
+};
+
+// Three-C breakdown of a cache's misses (Hill & Smith), in aggregate form:
+// compulsory = first references to a line, capacity = misses of a fully
+// associative LRU cache of equal size minus compulsory, conflict = actual
+// misses minus those of the fully associative cache. Conflict can be
+// negative when the real placement beats fully associative LRU.
+struct MissClasses {
+    uint64_t compulsory = 0;
+    uint64_t capacity = 0;
+    int64_t  conflict = 0;
+};
@@ -0,0 +1,409 @@
+"""Python bindings to the cache model, over its C interface (include/cache/c_api.h).
+
+Loads the cache_model_c shared library with ctypes: from the path in
+CACHE_MODEL_LIB if set, else from build/ at the repo root.
+
+Address arrays are handed to the simulator in place: a C-contiguous numpy
+uint64 array, or any writable buffer of 8-byte unsigned integers (e.g.
+array.array('Q')), is never copied. Other inputs (other integer dtypes,
+lists, read-only buffers) are converted once per call. ctypes releases the
+GIL for the duration of every call into the library, so other Python
+threads keep running while a batch simulates, and distinct Cache or
+StackDistance objects can simulate concurrently from separate threads.
+One object must not be used from two threads at once.
+
+Outputs are numpy arrays when numpy is importable, else array.array.
+
+    import numpy as np
+    import cache_model as cm
+
+    addrs = (np.arange(1 << 20, dtype=np.uint64) * 64) % (1 << 22)
+    c = cm.Cache(32 * 1024, 64, 8, hit_latency=4, miss_penalty=100)
+    print(c.access(addrs), c.stats())
+
+    sd = cm.StackDistance(64, [64, 512], max_assoc=16)
+    sd.access(addrs)
+    mrc = sd.curves()[0]            # mrc.associativity vs mrc.miss_ratio
+
+    ts = cm.IntervalStats(cm.Cache(32 * 1024, 64, 8, 4, 100), interval=65536)
+    ts.access(addrs)
+    series = ts.history()           # dict of per-interval columns
+"""
+
+import array
+import ctypes
+import os
+from pathlib import Path
+
+try:
+    import numpy as np
+except ImportError:  # numpy is optional; outputs fall back to array.array
+    np = None
+
+POLICIES = ["LRU", "FIFO", "RANDOM", "TREE_PLRU", "BIT_PLRU", "SRRIP", "BRRIP"]
+
+_OK, _INVALID_ARGUMENT = 0, 1
+
+_u64p = ctypes.POINTER(ctypes.c_uint64)
+_u8p = ctypes.POINTER(ctypes.c_uint8)
+
+
+class _BatchStats(ctypes.Structure):
+    _fields_ = [(n, ctypes.c_uint64) for n in
+                ("accesses", "hits", "misses", "skipped", "reads", "writes", "total_latency")]
+
+
+class _CacheStats(ctypes.Structure):
+    _fields_ = [("accesses", ctypes.c_uint64), ("hits", ctypes.c_uint64),
+                ("misses", ctypes.c_uint64), ("compulsory", ctypes.c_uint64),
+                ("capacity", ctypes.c_uint64), ("conflict", ctypes.c_int64),
+                ("miss_rate", ctypes.c_double), ("amat", ctypes.c_double)]
+
+
+class _CurveInfo(ctypes.Structure):
+    _fields_ = [(n, ctypes.c_uint64) for n in
+                ("line_size", "num_sets", "accesses", "cold_misses", "beyond", "max_assoc")]
+
+
+def _find_library():
+    env = os.environ.get("CACHE_MODEL_LIB")
+    if env:
+        return env
+    root = Path(__file__).resolve().parent.parent
+    names = ("libcache_model_c.so", "libcache_model_c.dylib", "cache_model_c.dll")
+    for n in names:
+        p = root / "build" / n
+        if p.exists():
+            return str(p)
+    raise OSError("cache_model_c library not found; build it (cmake --build build) "
+                  "or set CACHE_MODEL_LIB")
+
+
+_lib = ctypes.CDLL(_find_library())
+
+
+def _declare(name, *argtypes):
+    fn = getattr(_lib, name)
+    fn.argtypes = list(argtypes)
+    fn.restype = ctypes.c_int
+    return fn
+
+
+_lib.cm_last_error.restype = ctypes.c_char_p
+_lib.cm_last_error.argtypes = []
+_lib.cm_cache_free.argtypes = [ctypes.c_void_p]
+_lib.cm_cache_free.restype = None
+_lib.cm_sd_free.argtypes = [ctypes.c_void_p]
+_lib.cm_sd_free.restype = None
+_lib.cm_intervals_free.argtypes = [ctypes.c_void_p]
+_lib.cm_intervals_free.restype = None
+
+_vp, _sz, _u64 = ctypes.c_void_p, ctypes.c_size_t, ctypes.c_uint64
+_cache_new = _declare("cm_cache_new", _u64, _u64, _u64, _u64, _u64, ctypes.c_int,
+                      ctypes.POINTER(_vp))
+_cache_access_batch = _declare("cm_cache_access_batch", _vp, _u64p, _sz, _u8p, _u8p, _u64p,
+                               ctypes.POINTER(_BatchStats))
+_cache_warm = _declare("cm_cache_warm", _vp, _u64p, _sz)
+_cache_stats = _declare("cm_cache_stats_get", _vp, ctypes.POINTER(_CacheStats))
+_cache_num_sets = _declare("cm_cache_num_sets", _vp, _u64p)
+_cache_reset_stats = _declare("cm_cache_reset_stats", _vp)
+_cache_flush = _declare("cm_cache_flush", _vp)
+_cache_classify = _declare("cm_cache_enable_miss_classification", _vp, ctypes.c_uint)
+_cache_sampling = _declare("cm_cache_enable_set_sampling", _vp, _u64, _u64)
+_cache_save = _declare("cm_cache_save_checkpoint", _vp, ctypes.c_char_p)
+_cache_restore = _declare("cm_cache_restore_checkpoint", _vp, ctypes.c_char_p)
+_sd_new = _declare("cm_sd_new", _u64, _u64p, _sz, _u64, ctypes.POINTER(_vp))
+_sd_access_batch = _declare("cm_sd_access_batch", _vp, _u64p, _sz)
+_sd_curve_info = _declare("cm_sd_curve_info", _vp, _sz, ctypes.POINTER(_CurveInfo))
+_sd_curve_misses = _declare("cm_sd_curve_misses", _vp, _sz, _u64p, _sz)
+_sd_curve_distances = _declare("cm_sd_curve_distances", _vp, _sz, _u64p, _sz)
+_iv_new = _declare("cm_intervals_new", _vp, _u64, ctypes.POINTER(_vp))
+_iv_access_batch = _declare("cm_intervals_access_batch", _vp, _u64p, _sz, _u8p)
+_iv_finish = _declare("cm_intervals_finish", _vp)
+_iv_count = _declare("cm_intervals_count", _vp, ctypes.POINTER(_sz))
+_iv_copy = _declare("cm_intervals_copy", _vp, _u64p, _sz)
+
+
+def _check(status):
+    if status == _OK:
+        return
+    msg = _lib.cm_last_error().decode(errors="replace")
+    raise (ValueError if status == _INVALID_ARGUMENT else RuntimeError)(msg)
+
+
+# ---- Buffers ----
+#
+# Each helper returns (ctypes pointer, element count, owner); the owner is
+# whatever object holds the memory and must stay referenced for the call.
+
+# Buffer formats accepted in place, by element size.
+_FORMATS = {8: ("Q", "L", "q", "l"), 1: ("B", "b", "?", "c")}
+
+
+def _input(data, ctype, code, dtype_name):
+    size = ctypes.sizeof(ctype)
+    if np is not None and isinstance(data, np.ndarray):
+        a = np.ascontiguousarray(data, dtype=getattr(np, dtype_name))
+        return a.ctypes.data_as(ctypes.POINTER(ctype)), a.size, a
+    try:
+        mv = memoryview(data)
+    except TypeError:       # a list or other iterable: convert once
+        return _input(array.array(code, data), ctype, code, dtype_name)
+    if mv.itemsize != size or mv.format.lstrip("@=<") not in _FORMATS[size] \
+            or not mv.c_contiguous:
+        return _input(array.array(code, mv.tolist()), ctype, code, dtype_name)
+    n = mv.nbytes // size
+    if n == 0:
+        return None, 0, mv
+    raw = mv.cast("B")
+    if mv.readonly:         # ctypes can only alias writable memory
+        buf = (ctypes.c_uint8 * mv.nbytes).from_buffer_copy(raw)
+    else:
+        buf = (ctypes.c_uint8 * mv.nbytes).from_buffer(raw)
+    return ctypes.cast(buf, ctypes.POINTER(ctype)), n, (mv, raw, buf)
+
+
+def _addresses(data):
+    return _input(data, ctypes.c_uint64, "Q", "uint64")
+
+
+def _flags(data, count):
+    if data is None:
+        return None, None
+    ptr, n, owner = _input(data, ctypes.c_uint8, "B", "uint8")
+    if n != count:
+        raise ValueError("is_write must have one entry per address")
+    return ptr, owner
+
+
+def _output(count, ctype=ctypes.c_uint64, code="Q", dtype_name="uint64"):
+    if np is not None:
+        a = np.zeros(count, dtype=getattr(np, dtype_name))
+        return a, a.ctypes.data_as(ctypes.POINTER(ctype))
+    a = array.array(code, bytes(count * ctypes.sizeof(ctype)))
+    if count == 0:
+        return a, None
+    buf = (ctype * count).from_buffer(a)
+    return a, ctypes.cast(buf, ctypes.POINTER(ctype))
+
+
+def _ratio(num, den):
+    if np is not None:
+        num = np.asarray(num, dtype=np.float64)
+        return np.divide(num, den, out=np.zeros_like(num), where=np.asarray(den) != 0)
+    if isinstance(den, (int, float)):
+        den = [den] * len(num)
+    return array.array("d", (n / d if d else 0.0 for n, d in zip(num, den)))
+
+
+def _policy_value(policy):
+    if isinstance(policy, int):
+        return policy
+    try:
+        return POLICIES.index(str(policy).upper())
+    except ValueError:
+        raise ValueError("unknown replacement policy %r; one of %s" % (policy, POLICIES)) from None
+
+
+# ---- Cache ----
+
+class Cache:
+    """A set-associative cache (the C++ Cache class)."""
+
+    def __init__(self, cache_size, line_size, associativity, hit_latency, miss_penalty,
+                 policy="LRU"):
+        h = _vp()
+        _check(_cache_new(cache_size, line_size, associativity, hit_latency, miss_penalty,
+                          _policy_value(policy), ctypes.byref(h)))
+        self._h = h
+
+    def close(self):
+        if getattr(self, "_h", None):
+            _lib.cm_cache_free(self._h)
+            self._h = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def access(self, addresses, is_write=None, per_reference=False):
+        """Simulates every address in order (Cache::access_batch).
+
+        Returns the batch's counters as a dict. With per_reference=True,
+        returns (counters, hits, latencies): a uint8 array, 1 per hit, and
+        a uint64 array of cycles, both one entry per address.
+        """
+        ptr, n, owner = _addresses(addresses)
+        wptr, wowner = _flags(is_write, n)
+        hits = lats = hptr = lptr = None
+        if per_reference:
+            hits, hptr = _output(n, ctypes.c_uint8, "B", "uint8")
+            lats, lptr = _output(n)
+        st = _BatchStats()
+        _check(_cache_access_batch(self._h, ptr, n, wptr, hptr, lptr, ctypes.byref(st)))
+        del owner, wowner
+        stats = {f: getattr(st, f) for f, _ in _BatchStats._fields_}
+        return (stats, hits, lats) if per_reference else stats
+
+    def warm(self, addresses):
+        """Installs the lines without counting anything (Cache::warm)."""
+        ptr, n, owner = _addresses(addresses)
+        _check(_cache_warm(self._h, ptr, n))
+        del owner
+
+    def stats(self):
+        """Running totals: accesses, hits, misses, miss classes, miss_rate, amat."""
+        st = _CacheStats()
+        _check(_cache_stats(self._h, ctypes.byref(st)))
+        return {f: getattr(st, f) for f, _ in _CacheStats._fields_}
+
+    @property
+    def num_sets(self):
+        n = _u64()
+        _check(_cache_num_sets(self._h, ctypes.byref(n)))
+        return n.value
+
+    def reset_stats(self):
+        _check(_cache_reset_stats(self._h))
+
+    def flush(self):
+        _check(_cache_flush(self._h))
+
+    def enable_miss_classification(self, seen_bits=24):
+        """Count compulsory/capacity/conflict misses (MissClassifier)."""
+        _check(_cache_classify(self._h, seen_bits))
+
+    def enable_set_sampling(self, ratio, seed=0):
+        _check(_cache_sampling(self._h, ratio, seed))
+
+    def save_checkpoint(self, path):
+        _check(_cache_save(self._h, os.fsencode(path)))
+
+    def restore_checkpoint(self, path):
+        _check(_cache_restore(self._h, os.fsencode(path)))
+
+
+# ---- Stack-distance analysis ----
+
+class MissRatioCurve:
+    """LRU miss-ratio curve for one set count, indexed by associativity 1..max_assoc."""
+
+    def __init__(self, info, misses, distances):
+        self.line_size = info.line_size
+        self.num_sets = info.num_sets
+        self.accesses = info.accesses
+        self.cold_misses = info.cold_misses
+        self.beyond = info.beyond
+        self.max_assoc = info.max_assoc
+        self.distance_counts = distances
+        self.misses = misses
+        self.miss_ratio = _ratio(misses, info.accesses)
+        if np is not None:
+            self.associativity = np.arange(1, info.max_assoc + 1, dtype=np.uint64)
+            self.capacity_bytes = self.associativity * np.uint64(info.num_sets * info.line_size)
+        else:
+            self.associativity = array.array("Q", range(1, info.max_assoc + 1))
+            self.capacity_bytes = array.array(
+                "Q", (a * info.num_sets * info.line_size for a in self.associativity))
+
+
+class StackDistance:
+    """Single-pass LRU stack-distance analysis (StackDistanceAnalyzer)."""
+
+    def __init__(self, line_size, set_counts, max_assoc):
+        counts = array.array("Q", set_counts)
+        buf = (ctypes.c_uint64 * len(counts)).from_buffer(counts) if len(counts) else None
+        h = _vp()
+        _check(_sd_new(line_size, ctypes.cast(buf, _u64p) if buf is not None else None,
+                       len(counts), max_assoc, ctypes.byref(h)))
+        self._h = h
+        self._curves = len(counts)
+
+    def close(self):
+        if getattr(self, "_h", None):
+            _lib.cm_sd_free(self._h)
+            self._h = None
+
+    def __del__(self):
+        self.close()
+
+    def access(self, addresses):
+        ptr, n, owner = _addresses(addresses)
+        _check(_sd_access_batch(self._h, ptr, n))
+        del owner
+
+    def curves(self):
+        """One MissRatioCurve per set count, in constructor order."""
+        out = []
+        for i in range(self._curves):
+            info = _CurveInfo()
+            _check(_sd_curve_info(self._h, i, ctypes.byref(info)))
+            misses, mptr = _output(info.max_assoc)
+            _check(_sd_curve_misses(self._h, i, mptr, info.max_assoc))
+            dist, dptr = _output(info.max_assoc)
+            _check(_sd_curve_distances(self._h, i, dptr, info.max_assoc))
+            out.append(MissRatioCurve(info, misses, dist))
+        return out
+
+
+# ---- Time series ----
+
+INTERVAL_COLUMNS = ("index", "start", "accesses", "hits", "misses", "total_latency")
+
+
+class IntervalStats:
+    """Per-interval counters of a cache's reference stream (IntervalStatsCollector).
+
+    Keeps `cache` alive; simulate through this object, not the cache, for
+    the references to be cut into intervals.
+    """
+
+    def __init__(self, cache, interval):
+        h = _vp()
+        _check(_iv_new(cache._h, interval, ctypes.byref(h)))
+        self._h = h
+        self.cache = cache
+
+    def close(self):
+        if getattr(self, "_h", None):
+            _lib.cm_intervals_free(self._h)
+            self._h = None
+
+    def __del__(self):
+        self.close()
+
+    def access(self, addresses, is_write=None):
+        ptr, n, owner = _addresses(addresses)
+        wptr, wowner = _flags(is_write, n)
+        _check(_iv_access_batch(self._h, ptr, n, wptr))
+        del owner, wowner
+
+    def finish(self):
+        """Emits the trailing partial interval, if any."""
+        _check(_iv_finish(self._h))
+
+    def history(self):
+        """Columns of every interval emitted so far (finish() first for the
+        tail): INTERVAL_COLUMNS as uint64 arrays, plus miss_rate and amat."""
+        n = _sz()
+        _check(_iv_count(self._h, ctypes.byref(n)))
+        rows = n.value
+        flat, ptr = _output(rows * len(INTERVAL_COLUMNS))
+        if rows:
+            _check(_iv_copy(self._h, ptr, rows))
+        width = len(INTERVAL_COLUMNS)
+        if np is not None:
+            table = flat.reshape(rows, width)
+            cols = {name: table[:, i].copy() for i, name in enumerate(INTERVAL_COLUMNS)}
+            simulated = cols["hits"] + cols["misses"]
+        else:
+            cols = {name: flat[i::width] for i, name in enumerate(INTERVAL_COLUMNS)}
+            simulated = [h + m for h, m in zip(cols["hits"], cols["misses"])]
+        cols["miss_rate"] = _ratio(cols["misses"], simulated)
+        cols["amat"] = _ratio(cols["total_latency"], simulated)
+        return cols
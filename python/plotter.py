@@ -22,6 +22,9 @@ CANDIDATE_X = [
 
 METRICS = ["miss_rate", "amat"]
 
+# Simulator cost per sweep point (host side), plotted when present
+HOST_METRICS = ["ns_per_access", "accesses_per_sec"]
+
 def pick_x_column(d: pd.DataFrame) -> str | None:
     """
     Pick an x-axis column automatically:
@@ -43,7 +46,7 @@ def is_categorical_x(xcol: str) -> bool:
 def stable_sort(d: pd.DataFrame, xcol: str) -> pd.DataFrame:
     d = d.copy()
     if xcol == "policy":
-        order = ["LRU", "FIFO", "RANDOM"]
+        order = ["LRU", "FIFO", "RANDOM", "TREE_PLRU", "BIT_PLRU", "SRRIP", "BRRIP"]
         if "policy" in d.columns:
             d.loc[:, "policy"] = pd.Categorical(d["policy"], categories=order, ordered=True)
         return d.sort_values("policy")
@@ -125,8 +128,8 @@ for exp in experiments:
     elif xcol == "policy":
         xlabel = "Replacement policy"
 
-    for metric in METRICS:
-        if metric not in d.columns:
+    for metric in METRICS + HOST_METRICS:
+        if metric not in d.columns or d[metric].isna().all():
             continue
 
         title = f"{exp}: {metric} vs {xcol}"
@@ -140,4 +143,20 @@ for exp in experiments:
         else:
             plot_line(d, xcol, metric, title, xlabel, outpath)
 
+# Simulator throughput across experiments: one bar per experiment, so slow
+# configs and traces stand out next to the model metrics above.
+if "accesses_per_sec" in df.columns and not df["accesses_per_sec"].isna().all():
+    t = df.groupby("experiment", sort=True)["accesses_per_sec"].median().reset_index()
+    plt.figure()
+    plt.bar(t["experiment"], t["accesses_per_sec"] / 1e6)
+    plt.title("Simulator throughput (median per experiment)")
+    plt.xlabel("experiment")
+    plt.ylabel("simulated accesses/sec (millions)")
+    plt.xticks(rotation=45, ha="right")
+    plt.grid(True, axis="y")
+    outpath = OUT_DIR / "simulator_throughput.png"
+    plt.savefig(outpath, dpi=200, bbox_inches="tight")
+    plt.close()
+    print(f"Wrote {outpath}")
+
 print("\nDone. Open images in:", OUT_DIR)
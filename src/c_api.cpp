@@ -0,0 +1,311 @@
+#include "cache/c_api.h"
+#include "cache/cache_model.h"
+#include "cache/checkpoint.h"
+#include "cache/interval_stats.h"
+#include "cache/stack_distance.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct cm_cache {
+    Cache cache;
+};
+
+struct cm_stack_distance {
+    StackDistanceAnalyzer analyzer;
+};
+
+struct cm_intervals {
+    IntervalStatsCollector collector;
+};
+
+static thread_local std::string last_error;
+
+// Runs `fn`, turning any exception into a status and last_error.
+template <typename F>
+static cm_status guarded(F&& fn) {
+    try {
+        fn();
+        last_error.clear();
+        return CM_OK;
+    } catch (const std::invalid_argument& e) {
+        last_error = e.what();
+        return CM_INVALID_ARGUMENT;
+    } catch (const std::out_of_range& e) {
+        last_error = e.what();
+        return CM_INVALID_ARGUMENT;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return CM_ERROR;
+    } catch (...) {
+        last_error = "unknown error";
+        return CM_ERROR;
+    }
+}
+
+static void require(const void* p, const char* what) {
+    if (!p) throw std::invalid_argument(std::string(what) + " is null");
+}
+
+static ReplacementPolicy to_policy(int policy) {
+    if (policy < 0 || policy > static_cast<int>(ReplacementPolicy::BRRIP)) {
+        throw std::invalid_argument("unknown replacement policy " + std::to_string(policy));
+    }
+    return static_cast<ReplacementPolicy>(policy);
+}
+
+static MissRatioCurve curve_at(const cm_stack_distance* sd, size_t curve) {
+    require(sd, "analyzer");
+    std::vector<MissRatioCurve> curves = sd->analyzer.curves();
+    if (curve >= curves.size()) throw std::out_of_range("curve index out of range");
+    return std::move(curves[curve]);
+}
+
+extern "C" {
+
+const char* cm_last_error(void) { return last_error.c_str(); }
+
+const char* cm_policy_name(int policy) {
+    if (policy < 0 || policy > static_cast<int>(ReplacementPolicy::BRRIP)) return "UNKNOWN";
+    return replacement_policy_name(static_cast<ReplacementPolicy>(policy));
+}
+
+// ---- Cache ----
+
+cm_status cm_cache_new(uint64_t cache_size, uint64_t line_size, uint64_t associativity,
+                       uint64_t hit_latency, uint64_t miss_penalty, int policy,
+                       cm_cache** out) {
+    return guarded([&] {
+        require(out, "out");
+        *out = nullptr;
+        *out = new cm_cache{Cache(cache_size, line_size, associativity,
+                                  hit_latency, miss_penalty, to_policy(policy))};
+    });
+}
+
+void cm_cache_free(cm_cache* cache) { delete cache; }
+
+cm_status cm_cache_access_batch(cm_cache* cache, const uint64_t* addresses, size_t count,
+                                const uint8_t* is_write, uint8_t* hits, uint64_t* latencies,
+                                cm_batch_stats* stats) {
+    return guarded([&] {
+        require(cache, "cache");
+        if (count) require(addresses, "addresses");
+
+        BatchStats total;
+        if (!hits && !latencies) {
+            total = cache->cache.access_batch(addresses, count, is_write);
+        } else {
+            // Per-reference outcomes go through a bounded AccessResult
+            // buffer and are scattered into the caller's separate arrays.
+            constexpr size_t kResultChunk = 4096;
+            static thread_local std::vector<AccessResult> results(kResultChunk);
+            for (size_t off = 0; off < count; off += kResultChunk) {
+                const size_t n = std::min(kResultChunk, count - off);
+                total += cache->cache.access_batch(addresses + off, n,
+                                                   is_write ? is_write + off : nullptr,
+                                                   results.data());
+                for (size_t i = 0; i < n; i++) {
+                    if (hits) hits[off + i] = results[i].hit;
+                    if (latencies) latencies[off + i] = results[i].latency;
+                }
+            }
+        }
+        if (stats) {
+            *stats = cm_batch_stats{total.accesses, total.hits, total.misses, total.skipped,
+                                    total.reads, total.writes, total.total_latency};
+        }
+    });
+}
+
+cm_status cm_cache_warm(cm_cache* cache, const uint64_t* addresses, size_t count) {
+    return guarded([&] {
+        require(cache, "cache");
+        if (count) require(addresses, "addresses");
+        cache->cache.warm(addresses, count);
+    });
+}
+
+cm_status cm_cache_stats_get(const cm_cache* cache, cm_cache_stats* out) {
+    return guarded([&] {
+        require(cache, "cache");
+        require(out, "out");
+        const Cache& c = cache->cache;
+        const MissClasses mc = c.get_miss_classes();
+        *out = cm_cache_stats{c.get_accesses(), c.get_hits(), c.get_misses(),
+                              mc.compulsory, mc.capacity, mc.conflict,
+                              c.get_miss_rate(), c.get_amat()};
+    });
+}
+
+cm_status cm_cache_num_sets(const cm_cache* cache, uint64_t* out) {
+    return guarded([&] {
+        require(cache, "cache");
+        require(out, "out");
+        *out = cache->cache.get_num_sets();
+    });
+}
+
+cm_status cm_cache_reset_stats(cm_cache* cache) {
+    return guarded([&] {
+        require(cache, "cache");
+        cache->cache.reset_stats();
+    });
+}
+
+cm_status cm_cache_flush(cm_cache* cache) {
+    return guarded([&] {
+        require(cache, "cache");
+        cache->cache.flush();
+    });
+}
+
+cm_status cm_cache_enable_miss_classification(cm_cache* cache, unsigned seen_bits) {
+    return guarded([&] {
+        require(cache, "cache");
+        cache->cache.enable_miss_classification(seen_bits);
+    });
+}
+
+cm_status cm_cache_enable_set_sampling(cm_cache* cache, uint64_t ratio, uint64_t seed) {
+    return guarded([&] {
+        require(cache, "cache");
+        cache->cache.enable_set_sampling(ratio, seed);
+    });
+}
+
+cm_status cm_cache_save_checkpoint(const cm_cache* cache, const char* path) {
+    return guarded([&] {
+        require(cache, "cache");
+        require(path, "path");
+        cache->cache.save_checkpoint(std::string(path));
+    });
+}
+
+cm_status cm_cache_restore_checkpoint(cm_cache* cache, const char* path) {
+    return guarded([&] {
+        require(cache, "cache");
+        require(path, "path");
+        cache->cache.restore_checkpoint(CacheSnapshot(path));
+    });
+}
+
+// ---- Stack-distance analysis ----
+
+cm_status cm_sd_new(uint64_t line_size, const uint64_t* set_counts, size_t set_count_len,
+                    uint64_t max_assoc, cm_stack_distance** out) {
+    return guarded([&] {
+        require(out, "out");
+        *out = nullptr;
+        if (set_count_len) require(set_counts, "set_counts");
+        std::vector<size_t> sets(set_counts, set_counts + set_count_len);
+        *out = new cm_stack_distance{StackDistanceAnalyzer(line_size, std::move(sets), max_assoc)};
+    });
+}
+
+void cm_sd_free(cm_stack_distance* sd) { delete sd; }
+
+cm_status cm_sd_access_batch(cm_stack_distance* sd, const uint64_t* addresses, size_t count) {
+    return guarded([&] {
+        require(sd, "analyzer");
+        if (count) require(addresses, "addresses");
+        sd->analyzer.access_batch(addresses, count);
+    });
+}
+
+cm_status cm_sd_curve_info(const cm_stack_distance* sd, size_t curve, cm_curve_info* out) {
+    return guarded([&] {
+        require(out, "out");
+        const MissRatioCurve c = curve_at(sd, curve);
+        *out = cm_curve_info{c.line_size, c.num_sets, c.accesses, c.cold_misses,
+                             c.beyond, c.max_assoc()};
+    });
+}
+
+cm_status cm_sd_curve_misses(const cm_stack_distance* sd, size_t curve, uint64_t* out, size_t len) {
+    return guarded([&] {
+        const MissRatioCurve c = curve_at(sd, curve);
+        if (len != c.max_assoc()) throw std::invalid_argument("output length must equal max_assoc");
+        if (len) require(out, "out");
+        // Running prefix of the distance histogram: hits(a) in one pass.
+        uint64_t hits = 0;
+        for (size_t a = 0; a < len; a++) {
+            hits += c.distance_counts[a];
+            out[a] = c.accesses - hits;
+        }
+    });
+}
+
+cm_status cm_sd_curve_distances(const cm_stack_distance* sd, size_t curve, uint64_t* out, size_t len) {
+    return guarded([&] {
+        const MissRatioCurve c = curve_at(sd, curve);
+        if (len != c.distance_counts.size()) {
+            throw std::invalid_argument("output length must equal max_assoc");
+        }
+        if (len) require(out, "out");
+        std::copy(c.distance_counts.begin(), c.distance_counts.end(), out);
+    });
+}
+
+// ---- Time series ----
+
+cm_status cm_intervals_new(cm_cache* cache, uint64_t interval, cm_intervals** out) {
+    return guarded([&] {
+        require(cache, "cache");
+        require(out, "out");
+        *out = nullptr;
+        IntervalStatsConfig config;
+        config.interval = interval;
+        *out = new cm_intervals{IntervalStatsCollector(cache->cache, config)};
+    });
+}
+
+void cm_intervals_free(cm_intervals* iv) { delete iv; }
+
+cm_status cm_intervals_access_batch(cm_intervals* iv, const uint64_t* addresses, size_t count,
+                                    const uint8_t* is_write) {
+    return guarded([&] {
+        require(iv, "collector");
+        if (count) require(addresses, "addresses");
+        iv->collector.access_batch(addresses, count, is_write);
+    });
+}
+
+cm_status cm_intervals_finish(cm_intervals* iv) {
+    return guarded([&] {
+        require(iv, "collector");
+        iv->collector.finish();
+    });
+}
+
+cm_status cm_intervals_count(const cm_intervals* iv, size_t* out) {
+    return guarded([&] {
+        require(iv, "collector");
+        require(out, "out");
+        *out = iv->collector.history().size();
+    });
+}
+
+cm_status cm_intervals_copy(const cm_intervals* iv, uint64_t* out, size_t rows) {
+    return guarded([&] {
+        require(iv, "collector");
+        const std::vector<IntervalRecord>& h = iv->collector.history();
+        if (rows > h.size()) throw std::invalid_argument("more rows requested than recorded");
+        if (rows) require(out, "out");
+        for (size_t i = 0; i < rows; i++) {
+            const IntervalRecord& r = h[i];
+            uint64_t* row = out + 6 * i;
+            row[0] = r.index;
+            row[1] = r.start;
+            row[2] = r.accesses;
+            row[3] = r.hits;
+            row[4] = r.misses;
+            row[5] = r.total_latency;
+        }
+    });
+}
+
+}   // extern "C"
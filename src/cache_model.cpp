@@ -1,38 +1,37 @@
 #include "cache/cache_model.h"
+#include "cache/checkpoint.h"
+#include "cache/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <stdexcept>
 
+static TimingParams fixed_timing(size_t hit_latency, size_t miss_penalty) {
+    TimingParams t;
+    t.hit_latency = hit_latency;
+    t.miss_penalty = miss_penalty;
+    return t;
+}
+
+static TimingParams memory_timing(size_t hit_latency, MemoryTiming mem_timing) {
+    TimingParams t;
+    t.hit_latency = hit_latency;
+    t.miss_penalty = 0;          // not used when use_mem_timing=true
+    t.mem_timing = mem_timing;
+    t.use_mem_timing = true;
+    return t;
+}
+
 Cache::Cache(size_t cache_size,
              size_t line_size,
              size_t associativity,
              size_t hit_latency,
              size_t miss_penalty,
              ReplacementPolicy policy)
-    : cache_size(cache_size),
-      line_size(line_size),
-      associativity(associativity),
-      hit_latency(hit_latency),
-      miss_penalty(miss_penalty),
-      policy(policy)
+    : Cache(cache_size, line_size, associativity, fixed_timing(hit_latency, miss_penalty), policy)
 {
-    if (line_size == 0 || associativity == 0) {
-        throw std::invalid_argument("line_size and associativity must be > 0");
-    }
-    if (cache_size == 0 || cache_size % (line_size * associativity) != 0) {
-        throw std::invalid_argument("cache_size must be a multiple of (line_size * associativity)");
-    }
-
-    num_sets = cache_size / (line_size * associativity);
-    if (num_sets == 0) {
-        throw std::invalid_argument("num_sets computed as 0 (check parameters)");
-    }
-
-    sets.resize(num_sets);
-    for (auto& set : sets) {
-        set.lines.resize(associativity);
-    }
-
-    // Seed RNG (simple): mix in some params so different configs vary.
-    rng_state ^= (cache_size * 1315423911ULL) ^ (line_size * 2654435761ULL) ^ (associativity * 889523592379ULL);
 }
 
 Cache::Cache(size_t cache_size,
@@ -41,164 +40,723 @@ Cache::Cache(size_t cache_size,
              size_t hit_latency,
              MemoryTiming mem_timing,
              ReplacementPolicy policy)
-    : cache_size(cache_size),
-      line_size(line_size),
-      associativity(associativity),
-      hit_latency(hit_latency),
-      miss_penalty(0),          // not used when use_mem_timing=true
-      policy(policy),
-      mem_timing(mem_timing),
-      use_mem_timing(true)
+    : Cache(cache_size, line_size, associativity, memory_timing(hit_latency, mem_timing), policy)
+{
+}
+
+Cache::Cache(size_t cache_size,
+             size_t line_size,
+             size_t associativity,
+             TimingParams timing,
+             ReplacementPolicy policy)
+    : impl(make_impl(cache_size, line_size, associativity, timing, policy))
 {
-    if (line_size == 0 || associativity == 0) {
+}
+
+void Cache::reconfigure(size_t cache_size, size_t line_size, size_t associativity,
+                        TimingParams timing, ReplacementPolicy new_policy) {
+    if (new_policy == policy()) {
+        visit([&](auto& c) { c.reconfigure(cache_size, line_size, associativity, timing); });
+        return;
+    }
+    IStorage* next = get_next_level();
+    const bool classify = miss_classification_enabled();
+    const unsigned seen_bits = miss_classification_seen_bits();
+    impl = make_impl(cache_size, line_size, associativity, timing, new_policy);
+    set_next_level(next);
+    if (classify) enable_miss_classification(seen_bits);
+}
+
+void Cache::save_checkpoint(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("cannot open checkpoint file: " + path);
+    }
+    visit([&](const auto& c) { c.save_checkpoint(out); });
+}
+
+Cache::Impl Cache::make_impl(size_t cache_size, size_t line_size, size_t associativity,
+                             TimingParams timing, ReplacementPolicy policy) {
+    switch (policy) {
+        case ReplacementPolicy::LRU:       return BasicCache<LruPolicy>(cache_size, line_size, associativity, timing);
+        case ReplacementPolicy::FIFO:      return BasicCache<FifoPolicy>(cache_size, line_size, associativity, timing);
+        case ReplacementPolicy::RANDOM:    return BasicCache<RandomPolicy>(cache_size, line_size, associativity, timing);
+        case ReplacementPolicy::TREE_PLRU: return BasicCache<TreePlruPolicy>(cache_size, line_size, associativity, timing);
+        case ReplacementPolicy::BIT_PLRU:  return BasicCache<BitPlruPolicy>(cache_size, line_size, associativity, timing);
+        case ReplacementPolicy::SRRIP:     return BasicCache<SrripPolicy>(cache_size, line_size, associativity, timing);
+        case ReplacementPolicy::BRRIP:     return BasicCache<BrripPolicy>(cache_size, line_size, associativity, timing);
+        default:
+            throw std::invalid_argument("unknown replacement policy");
+    }
+}
+
+template <typename Policy>
+BasicCache<Policy>::BasicCache(size_t cache_size,
+                               size_t line_size,
+                               size_t associativity,
+                               TimingParams timing)
+{
+    configure(cache_size, line_size, associativity, timing);
+}
+
+template <typename Policy>
+void BasicCache<Policy>::reconfigure(size_t cache_size,
+                                     size_t line_size,
+                                     size_t associativity,
+                                     TimingParams timing) {
+    configure(cache_size, line_size, associativity, timing);
+}
+
+template <typename Policy>
+void BasicCache<Policy>::configure(size_t new_cache_size,
+                                   size_t new_line_size,
+                                   size_t new_associativity,
+                                   TimingParams new_timing) {
+    // Validate before touching any state, so a rejected reconfigure
+    // leaves the cache as it was.
+    if (new_line_size == 0 || new_associativity == 0) {
         throw std::invalid_argument("line_size and associativity must be > 0");
     }
-    if (cache_size == 0 || cache_size % (line_size * associativity) != 0) {
+    if (new_cache_size == 0 || new_cache_size % (new_line_size * new_associativity) != 0) {
         throw std::invalid_argument("cache_size must be a multiple of (line_size * associativity)");
     }
-
-    num_sets = cache_size / (line_size * associativity);
-    if (num_sets == 0) {
+    if (new_cache_size / (new_line_size * new_associativity) == 0) {
         throw std::invalid_argument("num_sets computed as 0 (check parameters)");
     }
+    // Policy init checks its own constraints before it changes anything.
+    repl.init(new_cache_size / (new_line_size * new_associativity), new_associativity);
+
+    cache_size = new_cache_size;
+    line_size = new_line_size;
+    associativity = new_associativity;
+    timing = new_timing;
+    num_sets = cache_size / (line_size * associativity);
 
-    sets.resize(num_sets);
-    for (auto& set : sets) {
-        set.lines.resize(associativity);
+    init_geometry();
+
+    // assign() reuses the existing buffers whenever they are big enough.
+    const size_t num_lines = num_sets * associativity;
+    tags.assign(num_lines, 0);
+    set_meta.assign(num_sets, SetMeta{});
+    epoch = 0;
+
+    set_sampled.clear();
+    sample_counts.clear();
+    sampled_sets = num_sets;
+    if (classifier) classifier->reset(num_lines, classifier_seen_bits);
+
+    lane = Lane{};
+
+    // Seed RNG (simple): mix in some params so different configs vary.
+    rng_state = kRngSeed ^ (cache_size * 1315423911ULL) ^ (line_size * 2654435761ULL) ^ (associativity * 889523592379ULL);
+}
+
+
+template <typename Policy>
+void BasicCache<Policy>::init_geometry() {
+    line_div = FastDivider(line_size);
+    set_div = FastDivider(num_sets);
+    set_mask = set_div.is_pow2 ? static_cast<uint64_t>(num_sets - 1) : 0;
+    tag_match = (associativity >= kTagMatchMinWays) ? select_tag_match() : nullptr;
+    hashed = num_sets == 1 && associativity >= kHashedMinWays;
+    if (hashed) line_index.reset(associativity);
+}
+
+template <typename Policy>
+void BasicCache<Policy>::split_address(uint64_t addr, uint64_t& index, uint64_t& tag) const {
+    const uint64_t line = line_div.divide(addr);
+    if (set_div.is_pow2) {
+        index = line & set_mask;
+        tag = line >> set_div.shift;
+    } else {
+        tag = set_div.divide(line);
+        index = line - tag * num_sets;
     }
+}
 
-    rng_state ^= (cache_size * 1315423911ULL) ^ (line_size * 2654435761ULL) ^ (associativity * 889523592379ULL);
+template <typename Policy>
+uint64_t BasicCache<Policy>::extract_index(uint64_t addr) const {
+    uint64_t index, tag;
+    split_address(addr, index, tag);
+    return index;
 }
 
+template <typename Policy>
+uint64_t BasicCache<Policy>::extract_tag(uint64_t addr) const {
+    uint64_t index, tag;
+    split_address(addr, index, tag);
+    return tag;
+}
 
-uint64_t Cache::extract_index(uint64_t addr) const {
-    return (addr / line_size) % num_sets;
+// splitmix64 finalizer, used to derive independent per-set RNG seeds.
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
 }
 
-uint64_t Cache::extract_tag(uint64_t addr) const {
-    return (addr / line_size) / num_sets;
+template <typename Policy>
+uint64_t BasicCache<Policy>::next_rand() {
+    return xorshift64star(rng_state);
 }
 
-// Simple xorshift64* RNG for RANDOM replacement
-uint64_t Cache::next_rand() {
-    uint64_t x = rng_state;
-    x ^= x >> 12;
-    x ^= x << 25;
-    x ^= x >> 27;
-    rng_state = x;
-    return x * 2685821657736338717ULL;
+template <typename Policy>
+size_t BasicCache<Policy>::find_way(size_t base, size_t ways, uint64_t tag) const {
+    const uint64_t* set_tags = &tags[base];
+
+    if (!tag_match) {
+        for (size_t way = 0; way < ways; way++) {
+            if (set_tags[way] == tag) return way;
+        }
+        return associativity;
+    }
+
+    for (size_t first = 0; first < ways; first += 64) {
+        const uint64_t candidates = tag_match(set_tags + first, std::min<size_t>(64, ways - first), tag);
+        if (candidates) return first + static_cast<size_t>(__builtin_ctzll(candidates));
+    }
+    return associativity;
 }
 
-Cache::CacheLine* Cache::pick_victim(CacheSet& set) {
-    // Prefer an invalid line first (empty slot)
-    for (auto& line : set.lines) {
-        if (!line.valid) return &line;
+template <typename Policy>
+template <bool kCount>
+bool BasicCache<Policy>::access_line(uint64_t index, uint64_t tag, Lane& ln) {
+    const size_t set = static_cast<size_t>(index);
+    const size_t base = set * associativity;
+
+#ifdef CACHE_MODEL_MISS_CLASSES
+    if (classifier) classifier->observe(tag * num_sets + index, kCount);
+#endif
+
+    // Same line as this lane's previous reference: still where it was left.
+    if (set == ln.last_set && tag == ln.last_tag) {
+        count_hit<kCount>(set, ln);
+        repl.on_hit(set, ln.last_way);
+        return true;
     }
 
-    // Otherwise choose based on policy
-    CacheLine* victim = &set.lines[0];
+    SetMeta& meta = set_meta[set];
+    if (meta.epoch != epoch) {
+        // First reference since a flush: empty the set now.
+        meta.epoch = epoch;
+        meta.filled = 0;
+        meta.mru = 0;
+        repl.reset_set(set);
+        if (hashed) line_index.clear();
+    }
 
-    switch (policy) {
-        case ReplacementPolicy::LRU: {
-            // Smallest last_used => least recently used
-            for (auto& line : set.lines) {
-                if (line.last_used < victim->last_used) victim = &line;
-            }
-            return victim;
+    // Hit? Only the filled prefix of the set can match, and a tag occurs
+    // there at most once, so trying the set's MRU way first finds the same
+    // way as the scan.
+    const size_t ways = meta.filled;
+    size_t way = meta.mru;
+    if (way >= ways || tags[base + way] != tag) {
+        if (hashed) {
+            const uint32_t w = line_index.find(tag);
+            way = (w == LineIndex::kNone) ? associativity : w;
+        } else {
+            way = find_way(base, ways, tag);
         }
+    }
+    ln.last_set = set;
+    ln.last_tag = tag;
+    if (way != associativity) {
+        count_hit<kCount>(set, ln);
+        repl.on_hit(set, way);
+        meta.mru = static_cast<uint32_t>(way);
+        ln.last_way = way;
+        return true;
+    }
 
-        case ReplacementPolicy::FIFO: {
-            // Smallest inserted_at => oldest resident
-            for (auto& line : set.lines) {
-                if (line.inserted_at < victim->inserted_at) victim = &line;
-            }
-            return victim;
+    // Miss
+    if (kCount) {
+        ln.misses++;
+        if (!sample_counts.empty()) {
+            sample_counts[set].accesses++;
+            sample_counts[set].misses++;
         }
+    }
 
-        case ReplacementPolicy::RANDOM: {
-            const uint64_t r = next_rand();
-            const size_t way = static_cast<size_t>(r % set.lines.size());
-            return &set.lines[way];
-        }
+    // Victim selection: the next empty way while the set fills, otherwise
+    // the policy decides
+    uint64_t& rng = ln.set_rng ? ln.set_rng[set] : rng_state;
+    size_t victim;
+    if (ways < associativity) {
+        victim = ways;
+        meta.filled = static_cast<uint32_t>(ways + 1);
+    } else {
+        victim = repl.victim(set, rng);
+    }
 
-        default:
-            return victim;
+    // Fill/replace line
+    if (hashed) {
+        if (victim < ways) line_index.erase(tags[base + victim]);
+        line_index.insert(tag, static_cast<uint32_t>(victim));
+    }
+    tags[base + victim] = tag;
+    repl.on_fill(set, victim, rng);
+    meta.mru = static_cast<uint32_t>(victim);
+    ln.last_way = victim;
+
+    return false;
+}
+
+template <typename Policy>
+bool BasicCache<Policy>::access(uint64_t address, uint64_t& latency) {
+    uint64_t index, tag;
+    split_address(address, index, tag);
+    if (!is_sampled(index)) {
+        lane.skipped++;
+        latency = 0;
+        return false;
+    }
+
+    const bool hit = access_line<true>(index, tag, lane);
+    latency = hit ? timing.hit_latency : miss_latency(address);
+    return hit;
+}
+
+template <typename Policy>
+bool BasicCache<Policy>::lookup(uint64_t address) {
+    uint64_t index, tag;
+    split_address(address, index, tag);
+    if (!is_sampled(index)) {
+        lane.skipped++;
+        return false;
     }
+    return access_line<true>(index, tag, lane);
 }
 
-bool Cache::access(uint64_t address, uint64_t& latency) {
-    access_counter++;
+template <typename Policy>
+void BasicCache<Policy>::warm(const uint64_t* addresses, size_t count) {
+    for_each_staged(addresses, count, [&](size_t, uint64_t index, uint64_t tag) {
+        if (is_sampled(index)) access_line<false>(index, tag, lane);
+    });
+}
 
-    const uint64_t index = extract_index(address);
-    const uint64_t tag   = extract_tag(address);
+template <typename Policy>
+uint64_t BasicCache<Policy>::miss_latency(uint64_t address) {
+    if (!next_level) return timing.hit_latency + effective_miss_penalty_cycles();
+    uint64_t below = 0;
+    next_level->access(address, below);
+    return timing.hit_latency + below;
+}
 
-    auto& set = sets[index];
+template <typename Policy>
+template <typename F>
+void BasicCache<Policy>::for_each_staged(const uint64_t* addresses, size_t count, F&& f) {
+    // Decompose addresses a few references ahead of the one being simulated
+    // and prefetch their sets, so the tag loads overlap with current work.
+    constexpr size_t kAhead = 8;
+    uint64_t ahead_index[kAhead];
+    uint64_t ahead_tag[kAhead];
+
+    auto stage = [&](size_t i) {
+        const size_t slot = i % kAhead;
+        split_address(addresses[i], ahead_index[slot], ahead_tag[slot]);
+        __builtin_prefetch(&tags[static_cast<size_t>(ahead_index[slot]) * associativity]);
+        __builtin_prefetch(&set_meta[static_cast<size_t>(ahead_index[slot])]);
+    };
+
+    for (size_t i = 0; i < count && i < kAhead; i++) stage(i);
+
+    for (size_t i = 0; i < count; i++) {
+        const size_t slot = i % kAhead;
+        const uint64_t index = ahead_index[slot];
+        const uint64_t tag = ahead_tag[slot];
+        if (i + kAhead < count) stage(i + kAhead);
+        f(i, index, tag);
+    }
+}
 
-    // Hit?
-    for (auto& line : set.lines) {
-        if (line.valid && line.tag == tag) {
-            hits++;
-            line.last_used = access_counter; // LRU touch
-            latency = hit_latency;
-            return true;
+template <typename Policy>
+BatchStats BasicCache<Policy>::access_batch(const uint64_t* addresses,
+                               size_t count,
+                               const uint8_t* is_write,
+                               AccessResult* results) {
+    const uint64_t hit_lat = timing.hit_latency;
+    const uint64_t hits_before = lane.hits;
+    const uint64_t misses_before = lane.misses;
+    const uint64_t skipped_before = lane.skipped;
+    uint64_t total_latency = 0;
+
+    for_each_staged(addresses, count, [&](size_t i, uint64_t index, uint64_t tag) {
+        if (!is_sampled(index)) {
+            lane.skipped++;
+            if (results) {
+                results[i].hit = false;
+                results[i].latency = 0;
+            }
+            return;
+        }
+        const bool hit = access_line<true>(index, tag, lane);
+        const uint64_t lat = hit ? hit_lat : miss_latency(addresses[i]);
+        total_latency += lat;
+        if (results) {
+            results[i].hit = hit;
+            results[i].latency = lat;
         }
+    });
+
+    BatchStats stats;
+    stats.accesses = count;
+    stats.hits = lane.hits - hits_before;
+    stats.misses = lane.misses - misses_before;
+    stats.skipped = lane.skipped - skipped_before;
+    if (is_write) {
+        for (size_t i = 0; i < count; i++) stats.writes += (is_write[i] != 0);
     }
+    stats.reads = count - stats.writes;
+    stats.total_latency = total_latency;
+    return stats;
+}
 
-    // Miss
-    misses++;
-    latency = hit_latency + effective_miss_penalty_cycles();
+template <typename Policy>
+BatchStats BasicCache<Policy>::access_partitioned(const uint64_t* addresses,
+                                     size_t count,
+                                     ThreadPool& pool) {
+    if (next_level) {
+        throw std::logic_error("access_partitioned cannot forward misses to a shared next level");
+    }
+    if (classifier) {
+        throw std::logic_error("access_partitioned cannot feed the shared miss classifier");
+    }
 
-    // Victim selection
-    CacheLine* victim = pick_victim(set);
+    const size_t parts = std::max<size_t>(1, std::min(pool.size(), num_sets));
+
+    // Partition p owns sets [p * num_sets / parts, (p + 1) * num_sets / parts).
+    auto part_of = [&](uint64_t index) {
+        return static_cast<size_t>((index * parts) / num_sets);
+    };
+
+    struct Ref {
+        uint64_t index;
+        uint64_t tag;
+    };
+
+    // Per-set RNG streams, so random choices depend only on the set's own
+    // reference sequence and not on which worker simulates it.
+    std::vector<uint64_t> set_rng;
+    if (Policy::kUsesRng) {
+        set_rng.resize(num_sets);
+        for (size_t i = 0; i < num_sets; i++) set_rng[i] = mix64(rng_state ^ mix64(i));
+        next_rand();
+    }
 
-    // Fill/replace line
-    victim->valid = true;
-    victim->tag = tag;
+    std::vector<Lane> lanes(parts);
+    for (Lane& ln : lanes) ln.set_rng = set_rng.empty() ? nullptr : set_rng.data();
+
+    // The trace goes through in chunks of kPartitionChunk references, so the
+    // decomposed copy stays bounded however long (or mmapped) the trace is.
+    constexpr size_t kPartitionChunk = size_t(1) << 16;
+    const size_t slices = parts;
+    std::vector<std::vector<std::vector<Ref>>> buckets(slices, std::vector<std::vector<Ref>>(parts));
+    for (size_t base = 0; base < count; base += kPartitionChunk) {
+        const size_t n = std::min(kPartitionChunk, count - base);
+
+        // Phase 1: each worker decomposes one slice of the chunk and buckets
+        // it by owning partition, preserving trace order within every bucket.
+        pool.parallel_for(slices, [&](size_t s) {
+            const size_t begin = base + n * s / slices;
+            const size_t end = base + n * (s + 1) / slices;
+            auto& out = buckets[s];
+            for (auto& b : out) {
+                b.clear();
+                b.reserve((end - begin) / parts + 1);
+            }
+            for (size_t i = begin; i < end; i++) {
+                Ref r;
+                split_address(addresses[i], r.index, r.tag);
+                if (is_sampled(r.index)) out[part_of(r.index)].push_back(r);
+            }
+        });
+
+        // Phase 2: each worker replays its partition slice by slice.
+        // Replacement state is per set, so workers never touch each other's
+        // metadata.
+        pool.parallel_for(parts, [&](size_t p) {
+            Lane& ln = lanes[p];
+            for (size_t s = 0; s < slices; s++) {
+                for (const Ref& r : buckets[s][p]) access_line<true>(r.index, r.tag, ln);
+            }
+        });
+    }
 
-    // Update replacement metadata
-    victim->last_used = access_counter;     // for LRU
-    victim->inserted_at = access_counter;   // for FIFO
+    BatchStats stats;
+    stats.accesses = count;
+    for (const Lane& ln : lanes) {
+        stats.hits += ln.hits;
+        stats.misses += ln.misses;
+    }
+    stats.skipped = count - stats.hits - stats.misses;
+    stats.reads = count;
+    stats.total_latency = stats.hits * timing.hit_latency
+                        + stats.misses * (timing.hit_latency + effective_miss_penalty_cycles());
+
+    lane.hits += stats.hits;
+    lane.misses += stats.misses;
+    lane.skipped += stats.skipped;
+    lane.last_set = Lane::kNoSet;   // the workers may have evicted it
+    return stats;
+}
 
-    return false;
+template <typename Policy>
+void BasicCache<Policy>::print_stats() const {
+    const FunctionalResult f = functional_result();
+
+    std::cout << "Hits: " << f.hits << "\n";
+    std::cout << "Misses: " << f.misses << "\n";
+    std::cout << "Miss rate: " << f.miss_rate() << "\n";
+    std::cout << "AMAT: " << evaluate_timing(f, timing).amat << " cycles\n";
 }
 
-void Cache::print_stats() const {
-    const uint64_t total = hits + misses;
-    const double miss_rate = (total == 0) ? 0.0 : static_cast<double>(misses) / static_cast<double>(total);
-    double amat = static_cast<double>(hit_latency) + miss_rate * static_cast<double>(effective_miss_penalty_cycles());
+template <typename Policy>
+void BasicCache<Policy>::reset_stats() {
+    lane.hits = 0;
+    lane.misses = 0;
+    lane.skipped = 0;
+    std::fill(sample_counts.begin(), sample_counts.end(), SampleCounts{});
+    if (classifier) classifier->reset_counts();
+}
+
+template <typename Policy>
+void BasicCache<Policy>::enable_set_sampling(size_t ratio, uint64_t seed) {
+    if (ratio == 0) {
+        throw std::invalid_argument("set sampling ratio must be > 0");
+    }
+    if (ratio > 1 && classifier) {
+        throw std::logic_error("set sampling cannot be combined with miss classification");
+    }
 
-    std::cout << "Hits: " << hits << "\n";
-    std::cout << "Misses: " << misses << "\n";
-    std::cout << "Miss rate: " << miss_rate << "\n";
-    std::cout << "AMAT: " << amat << " cycles\n";
+    set_sampled.clear();
+    sample_counts.clear();
+    sampled_sets = num_sets;
+    if (ratio > 1) {
+        // Hash-based choice keeps the sample spread over the index space
+        // rather than a contiguous (and possibly aliased) block of sets.
+        set_sampled.assign(num_sets, 0);
+        sampled_sets = 0;
+        size_t fallback = 0;
+        uint64_t fallback_hash = ~0ULL;
+        for (size_t i = 0; i < num_sets; i++) {
+            const uint64_t h = mix64(static_cast<uint64_t>(i) ^ mix64(seed));
+            if (h % ratio == 0) {
+                set_sampled[i] = 1;
+                sampled_sets++;
+            }
+            if (h < fallback_hash) {
+                fallback_hash = h;
+                fallback = i;
+            }
+        }
+        if (sampled_sets == 0) {
+            set_sampled[fallback] = 1;
+            sampled_sets = 1;
+        }
+        sample_counts.assign(num_sets, SampleCounts{});
+    }
+
+    reset_stats();
+    flush();
+}
+
+template <typename Policy>
+SetSampleEstimate BasicCache<Policy>::set_sample_estimate(double z) const {
+    SetSampleEstimate e;
+    e.sampled_sets = sampled_sets;
+    e.total_sets = num_sets;
+    e.simulated = lane.hits + lane.misses;
+    e.skipped = lane.skipped;
+    if (e.simulated == 0) {
+        if (e.skipped != 0) {
+            e.miss_rate = std::numeric_limits<double>::quiet_NaN();
+            e.ci_half_width = std::numeric_limits<double>::infinity();
+        }
+        return e;
+    }
+    e.miss_rate = static_cast<double>(lane.misses) / static_cast<double>(e.simulated);
+    if (sample_counts.empty()) return e;
+
+    // Ratio estimator over sampled sets: var(r) ~ (1 - n/N) s^2 / (n a^2),
+    // s^2 the sample variance of (m_i - r a_i), a the mean accesses per set.
+    const size_t n = sampled_sets;
+    if (n < 2) {
+        e.ci_half_width = 1.0;      // one set says nothing about the spread
+        return e;
+    }
+    double ss = 0.0;
+    for (size_t i = 0; i < num_sets; i++) {
+        if (!set_sampled[i]) continue;
+        const double d = static_cast<double>(sample_counts[i].misses)
+                       - e.miss_rate * static_cast<double>(sample_counts[i].accesses);
+        ss += d * d;
+    }
+    const double mean_a = static_cast<double>(e.simulated) / static_cast<double>(n);
+    const double fpc = 1.0 - static_cast<double>(n) / static_cast<double>(num_sets);
+    const double var = fpc * (ss / static_cast<double>(n - 1)) / (static_cast<double>(n) * mean_a * mean_a);
+    e.ci_half_width = z * std::sqrt(var);
+    return e;
 }
 
-void Cache::reset_stats() {
-    hits = 0;
-    misses = 0;
-    access_counter = 0;
+template <typename Policy>
+void BasicCache<Policy>::enable_miss_classification(unsigned seen_bits) {
+#ifdef CACHE_MODEL_MISS_CLASSES
+    if (set_sampling_enabled()) {
+        throw std::logic_error("miss classification cannot be combined with set sampling");
+    }
+    if (classifier) classifier->reset(num_sets * associativity, seen_bits);
+    else classifier.emplace(num_sets * associativity, seen_bits);
+    classifier_seen_bits = seen_bits;
+    reset_stats();
+    flush();
+#else
+    (void)seen_bits;
+    throw std::logic_error("miss classification was compiled out (CACHE_MODEL_MISS_CLASSES)");
+#endif
+}
+
+template <typename Policy>
+MissClasses BasicCache<Policy>::get_miss_classes() const {
+    if (!classifier) return MissClasses{};
+    return classifier->classes(lane.misses);
+}
+
+template <typename Policy>
+void BasicCache<Policy>::flush() {
+    if (classifier) classifier->clear();
+    lane.last_set = Lane::kNoSet;
+    if (++epoch != 0) return;
+
+    // Epoch wrapped: some set could still carry the new value from 2^32
+    // flushes ago, so clear everything eagerly this once.
+    std::fill(set_meta.begin(), set_meta.end(), SetMeta{});
+    repl.reset();
+    if (hashed) line_index.clear();
+}
 
-    // Flush cache lines
-    for (auto& set : sets) {
-        for (auto& line : set.lines) {
-            line.valid = false;
-            line.tag = 0;
-            line.last_used = 0;
-            line.inserted_at = 0;
+template <typename Policy>
+void BasicCache<Policy>::save_checkpoint(std::ostream& out) const {
+    static_assert(sizeof(SetMeta) == 12, "checkpoint stores SetMeta as three u32");
+
+    CheckpointHeader h{};
+    h.policy = static_cast<uint32_t>(Policy::kKind);
+    h.cache_size = cache_size;
+    h.line_size = line_size;
+    h.associativity = associativity;
+    h.rng_state = rng_state;
+    h.epoch = epoch;
+
+    std::vector<CheckpointSection> sections;
+    sections.push_back({tags.data(), tags.size() * sizeof(uint64_t)});
+    sections.push_back({set_meta.data(), set_meta.size() * sizeof(SetMeta)});
+    repl.state_arrays([&](const auto& v) {
+        sections.push_back({v.data(), v.size() * sizeof(v[0])});
+    });
+    write_checkpoint(out, h, sections);
+}
+
+template <typename Policy>
+void BasicCache<Policy>::restore_checkpoint(const CacheSnapshot& snapshot) {
+    const CheckpointHeader& h = snapshot.header();
+    if (h.policy != static_cast<uint32_t>(Policy::kKind) || h.cache_size != cache_size ||
+        h.line_size != line_size || h.associativity != associativity) {
+        throw std::invalid_argument("checkpoint geometry or policy does not match the cache");
+    }
+
+    // Check every section against this cache before changing anything.
+    std::vector<size_t> expected = {tags.size() * sizeof(uint64_t), set_meta.size() * sizeof(SetMeta)};
+    repl.state_arrays([&](const auto& v) { expected.push_back(v.size() * sizeof(v[0])); });
+    if (snapshot.section_count() != expected.size()) {
+        throw std::invalid_argument("checkpoint has the wrong number of state sections");
+    }
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (snapshot.section(i).bytes != expected[i]) {
+            throw std::invalid_argument("checkpoint state section has the wrong size");
         }
     }
+    const uint8_t* meta = static_cast<const uint8_t*>(snapshot.section(1).data);
+    for (size_t set = 0; set < num_sets; set++) {
+        SetMeta m;
+        std::memcpy(&m, meta + set * sizeof(SetMeta), sizeof(SetMeta));
+        if (m.filled > associativity || m.mru >= associativity) {
+            throw std::invalid_argument("checkpoint set metadata out of range");
+        }
+    }
+    std::vector<const void*> arrays;
+    for (size_t i = 2; i < snapshot.section_count(); i++) arrays.push_back(snapshot.section(i).data);
+    repl.validate_state(arrays);
+
+    size_t next = 0;
+    auto load = [&](auto& v) {
+        const CheckpointSection& s = snapshot.section(next++);
+        if (s.bytes) std::memcpy(v.data(), s.data, s.bytes);
+    };
+    load(tags);
+    load(set_meta);
+    repl.state_arrays(load);
+    epoch = h.epoch;
+    rng_state = h.rng_state;
+
+    if (hashed) {
+        line_index.clear();
+        if (set_meta[0].epoch == epoch) {
+            for (size_t w = 0; w < set_meta[0].filled; w++) {
+                line_index.insert(tags[w], static_cast<uint32_t>(w));
+            }
+        }
+    }
+    lane.last_set = Lane::kNoSet;
+    if (classifier) classifier->clear();
+    reset_stats();
+}
+
+template <typename Policy>
+uint64_t BasicCache<Policy>::get_hits() const { return functional_result().hits; }
+template <typename Policy>
+uint64_t BasicCache<Policy>::get_misses() const { return functional_result().misses; }
+template <typename Policy>
+uint64_t BasicCache<Policy>::get_accesses() const { return lane.hits + lane.misses + lane.skipped; }
+
+template <typename Policy>
+double BasicCache<Policy>::get_miss_rate() const {
+    return functional_result().miss_rate();
 }
 
-uint64_t Cache::get_hits() const { return hits; }
-uint64_t Cache::get_misses() const { return misses; }
-uint64_t Cache::get_accesses() const { return hits + misses; }
+template <typename Policy>
+double BasicCache<Policy>::get_amat() const {
+    return evaluate_timing(functional_result(), timing).amat;
+}
+
+template <typename Policy>
+FunctionalResult BasicCache<Policy>::functional_result() const {
+    FunctionalResult f;
+    f.line_size = line_size;
+    f.hits = lane.hits;
+    f.misses = lane.misses;
+    if (classifier) {
+        f.classified = true;
+        f.classes = classifier->classes(lane.misses);
+    }
+    const uint64_t simulated = lane.hits + lane.misses;
+    if (sample_counts.empty() || lane.skipped == 0) return f;
+    if (simulated == 0) {
+        f.estimable = false;
+        return f;
+    }
 
-double Cache::get_miss_rate() const {
-    const uint64_t total = get_accesses();
-    if (total == 0) return 0.0;
-    return static_cast<double>(misses) / static_cast<double>(total);
+    // Scale the sampled counts up to every reference seen.
+    const uint64_t total = simulated + lane.skipped;
+    f.misses = static_cast<uint64_t>(std::llround(
+        static_cast<double>(lane.misses) * static_cast<double>(total) / static_cast<double>(simulated)));
+    f.hits = total - f.misses;
+    return f;
 }
 
-double Cache::get_amat() const {
-    return static_cast<double>(hit_latency) + get_miss_rate() * static_cast<double>(effective_miss_penalty_cycles());
-}
\ No newline at end of file
+template class BasicCache<LruPolicy>;
+template class BasicCache<FifoPolicy>;
+template class BasicCache<RandomPolicy>;
+template class BasicCache<TreePlruPolicy>;
+template class BasicCache<BitPlruPolicy>;
+template class BasicCache<SrripPolicy>;
+template class BasicCache<BrripPolicy>;
@@ -0,0 +1,97 @@
+#include "cache/checkpoint.h"
+
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+static constexpr char kCheckpointMagic[8] = {'C', 'M', 'C', 'K', 'P', 'T', '0', '1'};
+
+static size_t padded(size_t bytes) { return (bytes + 7) & ~size_t(7); }
+
+// Word-wise FNV-1a style hash; section payloads are padded to whole words.
+static uint64_t mix_words(uint64_t h, const uint8_t* data, size_t bytes) {
+    for (size_t i = 0; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, data + i, 8);
+        h = (h ^ w) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static constexpr uint64_t kChecksumSeed = 0xcbf29ce484222325ULL;
+
+void write_checkpoint(std::ostream& out, CheckpointHeader header,
+                      const std::vector<CheckpointSection>& sections) {
+    std::memcpy(header.magic, kCheckpointMagic, 8);
+    header.version = kCheckpointVersion;
+    header.section_count = static_cast<uint32_t>(sections.size());
+
+    // The checksum covers the sections, so hash them before writing the
+    // header; the payload is only read, never buffered.
+    static const uint8_t zeros[8] = {};
+    uint64_t h = kChecksumSeed;
+    for (const CheckpointSection& s : sections) {
+        const uint64_t bytes = s.bytes;
+        h = mix_words(h, reinterpret_cast<const uint8_t*>(&bytes), 8);
+        const size_t whole = s.bytes & ~size_t(7);
+        h = mix_words(h, static_cast<const uint8_t*>(s.data), whole);
+        if (whole != s.bytes) {
+            uint8_t tail[8] = {};
+            std::memcpy(tail, static_cast<const uint8_t*>(s.data) + whole, s.bytes - whole);
+            h = mix_words(h, tail, 8);
+        }
+    }
+    header.checksum = h;
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const CheckpointSection& s : sections) {
+        const uint64_t bytes = s.bytes;
+        out.write(reinterpret_cast<const char*>(&bytes), 8);
+        if (s.bytes) out.write(static_cast<const char*>(s.data), static_cast<std::streamsize>(s.bytes));
+        out.write(reinterpret_cast<const char*>(zeros), static_cast<std::streamsize>(padded(s.bytes) - s.bytes));
+    }
+    out.flush();
+    if (!out) throw std::runtime_error("checkpoint write failed");
+}
+
+CacheSnapshot::CacheSnapshot(const std::string& path)
+    : file(path)
+{
+    const uint8_t* base = file.data();
+    const size_t size = file.size();
+    if (size < sizeof(head)) {
+        throw std::runtime_error("checkpoint too short: " + path);
+    }
+    std::memcpy(&head, base, sizeof(head));
+    if (std::memcmp(head.magic, kCheckpointMagic, 8) != 0) {
+        throw std::runtime_error("not a cache checkpoint: " + path);
+    }
+    if (head.version != kCheckpointVersion) {
+        throw std::runtime_error("unsupported checkpoint version: " + path);
+    }
+
+    size_t off = sizeof(head);
+    sections.reserve(head.section_count);
+    for (uint32_t i = 0; i < head.section_count; i++) {
+        if (size - off < 8) throw std::runtime_error("truncated checkpoint: " + path);
+        uint64_t bytes;
+        std::memcpy(&bytes, base + off, 8);
+        off += 8;
+        if (bytes > size - off || padded(static_cast<size_t>(bytes)) > size - off) {
+            throw std::runtime_error("truncated checkpoint: " + path);
+        }
+        sections.push_back(CheckpointSection{base + off, static_cast<size_t>(bytes)});
+        off += padded(static_cast<size_t>(bytes));
+    }
+    if (off != size) throw std::runtime_error("trailing bytes in checkpoint: " + path);
+
+    if (mix_words(kChecksumSeed, base + sizeof(head), size - sizeof(head)) != head.checksum) {
+        throw std::runtime_error("checkpoint checksum mismatch: " + path);
+    }
+}
+
+Cache CacheSnapshot::make_cache(TimingParams timing) const {
+    Cache c(cache_size(), line_size(), associativity(), timing, policy());
+    c.restore_checkpoint(*this);
+    return c;
+}
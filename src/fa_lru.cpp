@@ -0,0 +1,57 @@
+#include "cache/fa_lru.h"
+
+void FullyAssociativeLru::reset(size_t capacity) {
+    index.reset(capacity);
+    nodes.assign(capacity, Node{});
+    head = kNone;
+    tail = kNone;
+    live = 0;
+}
+
+void FullyAssociativeLru::unlink(uint32_t n) {
+    Node& node = nodes[n];
+    if (node.prev != kNone) nodes[node.prev].next = node.next;
+    else head = node.next;
+    if (node.next != kNone) nodes[node.next].prev = node.prev;
+    else tail = node.prev;
+}
+
+void FullyAssociativeLru::push_front(uint32_t n) {
+    Node& node = nodes[n];
+    node.prev = kNone;
+    node.next = head;
+    if (head != kNone) nodes[head].prev = n;
+    head = n;
+    if (tail == kNone) tail = n;
+}
+
+bool FullyAssociativeLru::access(uint64_t line) {
+    const uint32_t found = index.find(line);
+    if (found != kNone) {
+        if (found != head) {
+            unlink(found);
+            push_front(found);
+        }
+        return true;
+    }
+
+    uint32_t n;
+    if (live < nodes.size()) {
+        n = static_cast<uint32_t>(live++);
+    } else {
+        n = tail;
+        unlink(n);
+        index.erase(nodes[n].line);
+    }
+    nodes[n].line = line;
+    index.insert(line, n);
+    push_front(n);
+    return false;
+}
+
+void FullyAssociativeLru::clear() {
+    index.clear();
+    head = kNone;
+    tail = kNone;
+    live = 0;
+}
@@ -0,0 +1,40 @@
+#include "cache/hierarchy.h"
+
+#include <stdexcept>
+
+RuntimeHierarchy::RuntimeHierarchy(Memory memory)
+    : mem(std::make_unique<Memory>(std::move(memory)))
+{
+}
+
+size_t RuntimeHierarchy::add_level(Cache cache) {
+    caches.push_back(std::make_unique<Cache>(std::move(cache)));
+    Cache& added = *caches.back();
+    added.set_next_level(mem.get());
+    if (caches.size() > 1) caches[caches.size() - 2]->set_next_level(&added);
+    return caches.size() - 1;
+}
+
+bool RuntimeHierarchy::access(uint64_t address, uint64_t& latency) {
+    if (caches.empty()) return mem->access(address, latency);
+    return caches.front()->access(address, latency);
+}
+
+BatchStats RuntimeHierarchy::access_batch(const uint64_t* addresses,
+                                          size_t count,
+                                          const uint8_t* is_write,
+                                          AccessResult* results) {
+    if (caches.empty()) {
+        throw std::logic_error("RuntimeHierarchy has no cache levels");
+    }
+    return caches.front()->access_batch(addresses, count, is_write, results);
+}
+
+void RuntimeHierarchy::reset_stats() {
+    for (auto& c : caches) c->reset_stats();
+    mem->reset_stats();
+}
+
+void RuntimeHierarchy::flush() {
+    for (auto& c : caches) c->flush();
+}
@@ -0,0 +1,65 @@
+#include "cache/host_counters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int open_counter(uint64_t config, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group_fd < 0 ? 1 : 0;   // the leader gates the group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+HostCounters::HostCounters() {
+    fds[0] = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (fds[0] < 0) return;
+    fds[1] = open_counter(PERF_COUNT_HW_INSTRUCTIONS, fds[0]);
+    fds[2] = open_counter(PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+}
+
+HostCounters::~HostCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void HostCounters::start() {
+    if (!valid()) return;
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+HostCounters::Sample HostCounters::stop() {
+    Sample s;
+    if (!valid()) return s;
+    ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    uint64_t* out[3] = {&s.cycles, &s.instructions, &s.llc_misses};
+    bool* has[3] = {&s.has_cycles, &s.has_instructions, &s.has_llc_misses};
+    for (int i = 0; i < 3; i++) {
+        uint64_t v = 0;
+        if (fds[i] >= 0 && read(fds[i], &v, sizeof(v)) == static_cast<ssize_t>(sizeof(v))) {
+            *out[i] = v;
+            *has[i] = true;
+        }
+    }
+    return s;
+}
+
+#else
+
+HostCounters::HostCounters() {}
+HostCounters::~HostCounters() {}
+void HostCounters::start() {}
+HostCounters::Sample HostCounters::stop() { return Sample{}; }
+
+#endif
@@ -0,0 +1,219 @@
+#include "cache/interval_stats.h"
+#include "cache/cache_model.h"
+#include "cache/trace_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+
+TimeSeriesWriter::TimeSeriesWriter(const std::string& path, Format format, uint64_t interval,
+                                   size_t set_columns, size_t slots)
+    : out(path, format == Format::Binary ? std::ios::binary : std::ios::out),
+      format(format),
+      columns(set_columns),
+      free_slots(slots),
+      full_slots(slots)
+{
+    if (!out) {
+        throw std::runtime_error("cannot open time-series file: " + path);
+    }
+
+    // One slot per ring entry; all start out free.
+    const size_t n = free_slots.capacity();
+    records.resize(n);
+    set_hits.assign(n * columns, 0);
+    for (size_t i = 0; i < n; i++) free_slots.try_push(static_cast<uint32_t>(i));
+
+    write_header(interval);
+    if (!out) {
+        throw std::runtime_error("cannot write time-series file: " + path);
+    }
+    thread = std::thread([this] { drain(); });
+}
+
+TimeSeriesWriter::~TimeSeriesWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+IntervalRecord& TimeSeriesWriter::acquire(uint32_t*& hits) {
+    if (current == kNoSlot) {
+        while (!free_slots.try_pop(current)) {
+            waits++;
+            std::this_thread::yield();
+        }
+    }
+    hits = columns ? &set_hits[static_cast<size_t>(current) * columns] : nullptr;
+    return records[current];
+}
+
+void TimeSeriesWriter::publish() {
+    if (current == kNoSlot) {
+        throw std::logic_error("publish() without acquire()");
+    }
+    // Never fails: at most `slots` records exist, so full_slots has room.
+    full_slots.try_push(current);
+    current = kNoSlot;
+}
+
+void TimeSeriesWriter::close() {
+    if (thread.joinable()) {
+        closing.store(true, std::memory_order_release);
+        thread.join();
+        out.close();
+    }
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void TimeSeriesWriter::drain() {
+    for (;;) {
+        uint32_t slot;
+        if (full_slots.try_pop(slot)) {
+            if (!error) {
+                try {
+                    write_record(slot);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            free_slots.try_push(slot);
+            continue;
+        }
+        // Everything published before `closing` was set is visible by now.
+        if (closing.load(std::memory_order_acquire) && full_slots.empty()) break;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    out.flush();
+    if (!out && !error) error = std::make_exception_ptr(std::runtime_error("time-series write failed"));
+}
+
+static void put_u32(std::ofstream& out, uint32_t v) {
+    unsigned char b[4];
+    for (int i = 0; i < 4; i++) b[i] = static_cast<unsigned char>(v >> (8 * i));
+    out.write(reinterpret_cast<const char*>(b), 4);
+}
+
+static void put_u64(std::ofstream& out, uint64_t v) {
+    unsigned char b[8];
+    for (int i = 0; i < 8; i++) b[i] = static_cast<unsigned char>(v >> (8 * i));
+    out.write(reinterpret_cast<const char*>(b), 8);
+}
+
+void TimeSeriesWriter::write_header(uint64_t interval) {
+    if (format == Format::Binary) {
+        out.write("CMSERIES", 8);
+        put_u32(out, kTimeSeriesVersion);
+        put_u32(out, static_cast<uint32_t>(columns));
+        put_u64(out, interval);
+        put_u64(out, 0);
+        return;
+    }
+    out << "interval,start,accesses,hits,misses,miss_rate,amat";
+    for (size_t s = 0; s < columns; s++) out << ",set_" << s;
+    out << "\n";
+}
+
+void TimeSeriesWriter::write_record(uint32_t slot) {
+    const IntervalRecord& r = records[slot];
+    const uint32_t* hits = columns ? &set_hits[static_cast<size_t>(slot) * columns] : nullptr;
+
+    if (format == Format::Binary) {
+        put_u64(out, r.index);
+        put_u64(out, r.start);
+        put_u64(out, r.accesses);
+        put_u64(out, r.hits);
+        put_u64(out, r.misses);
+        put_u64(out, r.total_latency);
+        for (size_t s = 0; s < columns; s++) put_u32(out, hits[s]);
+    } else {
+        out << r.index << "," << r.start << "," << r.accesses << "," << r.hits << "," << r.misses << ","
+            << std::fixed << std::setprecision(6) << r.miss_rate() << ","
+            << std::setprecision(3) << r.amat();
+        for (size_t s = 0; s < columns; s++) out << "," << hits[s];
+        out << "\n";
+    }
+    if (!out) throw std::runtime_error("time-series write failed");
+}
+
+IntervalStatsCollector::IntervalStatsCollector(Cache& cache, IntervalStatsConfig config, TimeSeriesWriter* writer)
+    : cache(cache),
+      config(config),
+      writer(writer)
+{
+    if (config.interval == 0) {
+        throw std::invalid_argument("interval must be > 0");
+    }
+    if (config.per_set_hits && !writer) {
+        throw std::invalid_argument("per-set hits need a writer");
+    }
+    if (writer && writer->set_columns() != (config.per_set_hits ? cache.get_num_sets() : 0)) {
+        throw std::invalid_argument("writer must have one set column per cache set with per-set hits, else none");
+    }
+    if (config.per_set_hits) cur_set_hits.assign(cache.get_num_sets(), 0);
+}
+
+void IntervalStatsCollector::access_batch(const uint64_t* addresses, size_t count, const uint8_t* is_write) {
+    constexpr size_t kResultChunk = 4096;
+
+    size_t off = 0;
+    while (off < count) {
+        size_t n = std::min<uint64_t>(count - off, config.interval - cur.accesses);
+        if (config.per_set_hits) n = std::min(n, kResultChunk);
+
+        AccessResult* res = nullptr;
+        if (config.per_set_hits) {
+            results.resize(kResultChunk);
+            res = results.data();
+        }
+        const BatchStats b = cache.access_batch(addresses + off, n, is_write ? is_write + off : nullptr, res);
+        cur.accesses += n;
+        cur.hits += b.hits;
+        cur.misses += b.misses;
+        cur.total_latency += b.total_latency;
+        if (res) {
+            for (size_t i = 0; i < n; i++) {
+                if (res[i].hit) cur_set_hits[cache.set_index(addresses[off + i])]++;
+            }
+        }
+        off += n;
+
+        if (cur.accesses == config.interval) emit();
+    }
+}
+
+void IntervalStatsCollector::run(TraceSource& source) {
+    TraceChunk chunk;
+    while (source.next(chunk)) access_batch(chunk.addresses, chunk.count, chunk.types);
+    finish();
+}
+
+void IntervalStatsCollector::finish() {
+    if (cur.accesses > 0) emit();
+}
+
+void IntervalStatsCollector::emit() {
+    records.push_back(cur);
+    if (writer) {
+        uint32_t* hits = nullptr;
+        writer->acquire(hits) = cur;
+        if (hits) {
+            std::memcpy(hits, cur_set_hits.data(), cur_set_hits.size() * sizeof(uint32_t));
+        }
+        writer->publish();
+    }
+
+    const uint64_t next_start = cur.start + cur.accesses;
+    const uint64_t next_index = cur.index + 1;
+    cur = IntervalRecord{};
+    cur.index = next_index;
+    cur.start = next_start;
+    std::fill(cur_set_hits.begin(), cur_set_hits.end(), 0);
+}
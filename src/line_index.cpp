@@ -0,0 +1,54 @@
+#include "cache/line_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+void LineIndex::reset(size_t capacity) {
+    if (capacity == 0 || capacity >= (size_t(1) << 31)) {
+        throw std::invalid_argument("line index capacity must be in (0, 2^31)");
+    }
+
+    // Keep the table at most half full so probe sequences stay short.
+    size_t slots = 16;
+    unsigned bits = 4;
+    while (slots < 2 * capacity) {
+        slots <<= 1;
+        bits++;
+    }
+    table.assign(slots, Entry{});
+    generation = 0;
+    mask = slots - 1;
+    shift = 64 - bits;
+}
+
+void LineIndex::insert(uint64_t line, uint32_t value) {
+    size_t slot = home(line);
+    while (live(slot)) slot = (slot + 1) & mask;
+    table[slot].line = line;
+    table[slot].value = value;
+    table[slot].generation = generation;
+}
+
+void LineIndex::erase(uint64_t line) {
+    size_t hole = home(line);
+    while (live(hole) && table[hole].line != line) hole = (hole + 1) & mask;
+    if (!live(hole)) return;
+
+    // Backward-shift deletion: pull later entries of the cluster into the
+    // hole whenever the hole lies between their home slot and their slot.
+    for (size_t j = (hole + 1) & mask; live(j); j = (j + 1) & mask) {
+        const size_t h = home(table[j].line);
+        const bool movable = (j > hole) ? (h <= hole || h > j) : (h <= hole && h > j);
+        if (movable) {
+            table[hole] = table[j];
+            hole = j;
+        }
+    }
+    table[hole].value = kNone;
+}
+
+void LineIndex::clear() {
+    if (++generation != 0) return;
+    // Wrapped: entries from 2^32 clears ago would read as live again.
+    std::fill(table.begin(), table.end(), Entry{});
+}
@@ -0,0 +1,64 @@
+#include "cache/mapped_file.h"
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path, bool sequential) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open file: " + path);
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot stat file: " + path);
+    }
+    bytes = static_cast<size_t>(st.st_size);
+    if (bytes == 0) {
+        ::close(fd);
+        return;
+    }
+
+    void* p = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        bytes = 0;
+        throw std::runtime_error("cannot mmap file: " + path);
+    }
+    base = static_cast<const uint8_t*>(p);
+
+    if (sequential) ::madvise(p, bytes, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : base(other.base), bytes(other.bytes)
+{
+    other.base = nullptr;
+    other.bytes = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        base = other.base;
+        bytes = other.bytes;
+        other.base = nullptr;
+        other.bytes = 0;
+    }
+    return *this;
+}
+
+void MappedFile::release() {
+    if (base) ::munmap(const_cast<uint8_t*>(base), bytes);
+    base = nullptr;
+    bytes = 0;
+}
@@ -0,0 +1,59 @@
+#include "cache/miss_classifier.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+static unsigned checked_seen_shift(unsigned seen_bits) {
+    if (seen_bits < 6 || seen_bits > 36) {
+        throw std::invalid_argument("first-touch bitmap must have 2^6 to 2^36 bits");
+    }
+    return 64 - seen_bits;
+}
+
+MissClassifier::MissClassifier(size_t capacity_lines, unsigned seen_bits)
+    : seen_shift(checked_seen_shift(seen_bits)),
+      shadow(capacity_lines)
+{
+    assign_bitmap(seen_bits);
+}
+
+void MissClassifier::reset(size_t capacity_lines, unsigned seen_bits) {
+    seen_shift = checked_seen_shift(seen_bits);
+    shadow.reset(capacity_lines);
+    assign_bitmap(seen_bits);
+    reset_counts();
+}
+
+MissClasses MissClassifier::classes(uint64_t misses) const {
+    MissClasses c;
+    c.compulsory = first_touches;
+    c.capacity = shadow_misses - first_touches;
+    c.conflict = static_cast<int64_t>(misses) - static_cast<int64_t>(shadow_misses);
+    return c;
+}
+
+void MissClassifier::reset_counts() {
+    first_touches = 0;
+    shadow_misses = 0;
+}
+
+void MissClassifier::assign_bitmap(unsigned seen_bits) {
+    seen.assign((size_t(1) << seen_bits) / 64, 0);
+    block_epoch.assign((seen.size() + kBlockWords - 1) / kBlockWords, 0);
+    epoch = 0;
+}
+
+void MissClassifier::clear_block(size_t block) {
+    const size_t begin = block * kBlockWords;
+    const size_t end = std::min(begin + kBlockWords, seen.size());
+    std::fill(seen.begin() + begin, seen.begin() + end, 0);
+    block_epoch[block] = epoch;
+}
+
+void MissClassifier::clear() {
+    shadow.clear();
+    if (++epoch != 0) return;
+    // Wrapped: a block last zeroed 2^32 clears ago would look current.
+    std::fill(seen.begin(), seen.end(), 0);
+    std::fill(block_epoch.begin(), block_epoch.end(), 0);
+}
@@ -0,0 +1,54 @@
+#include "cache/multi_cache.h"
+#include "cache/thread_pool.h"
+
+#include <algorithm>
+
+MultiCacheDriver::MultiCacheDriver(ThreadPool* pool, size_t groups)
+    : pool(pool),
+      groups(groups)
+{
+}
+
+size_t MultiCacheDriver::add(Cache cache) {
+    caches.push_back(std::move(cache));
+    return caches.size() - 1;
+}
+
+void MultiCacheDriver::feed_range(size_t first, size_t last,
+                                  const uint64_t* addresses, size_t count, const uint8_t* is_write) {
+    for (size_t off = 0; off < count; off += kBlockRefs) {
+        const size_t n = std::min(kBlockRefs, count - off);
+        const uint8_t* w = is_write ? is_write + off : nullptr;
+        for (size_t i = first; i < last; i++) {
+            caches[i].access_batch(addresses + off, n, w);
+        }
+    }
+}
+
+std::vector<Cache> MultiCacheDriver::release() {
+    std::vector<Cache> out = std::move(caches);
+    caches.clear();
+    return out;
+}
+
+void MultiCacheDriver::access_batch(const uint64_t* addresses, size_t count, const uint8_t* is_write) {
+    const size_t n = caches.size();
+    if (n == 0 || count == 0) return;
+
+    const size_t g = std::min(n, pool ? (groups ? groups : pool->size()) : 1);
+    if (g <= 1) {
+        feed_range(0, n, addresses, count, is_write);
+        return;
+    }
+
+    pool->parallel_for(g, [&](size_t k) {
+        feed_range(n * k / g, n * (k + 1) / g, addresses, count, is_write);
+    });
+}
+
+void MultiCacheDriver::run(TraceSource& source) {
+    TraceChunk chunk;
+    while (source.next(chunk)) {
+        access_batch(chunk.addresses, chunk.count, chunk.types);
+    }
+}
@@ -0,0 +1,233 @@
+#include "cache/multicore.h"
+#include "cache/thread_pool.h"
+
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+MultiCoreSimulator::MultiCoreSimulator(size_t cores,
+                                       const std::vector<Cache>& private_levels,
+                                       const Cache& llc,
+                                       MultiCoreConfig config)
+    : config(config),
+      line_size(llc.get_line_size()),
+      llc_hit_latency(llc.timing_params().hit_latency)
+{
+    if (cores == 0) {
+        throw std::invalid_argument("a multi-core simulation needs at least one core");
+    }
+    if (config.quantum == 0) {
+        throw std::invalid_argument("quantum must be > 0");
+    }
+    if (llc.get_next_level() != nullptr) {
+        throw std::invalid_argument("the shared LLC must not have a next level");
+    }
+
+    // Largest power of two up to the requested count that divides the sets.
+    const size_t wanted = config.llc_slices ? config.llc_slices : cores;
+    const size_t sets = llc.get_num_sets();
+    size_t n = 1;
+    while (2 * n <= wanted && sets % (2 * n) == 0) {
+        n *= 2;
+        slice_shift++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        slices.emplace_back(llc.get_cache_size() / n, line_size, llc.get_associativity(),
+                            llc.timing_params(), llc.policy());
+    }
+
+    core_state.resize(cores);
+    for (Core& c : core_state) {
+        c.levels = private_levels;
+        c.queued.resize(n);
+    }
+    tallies.resize(n);
+    for (SliceTally& t : tallies) {
+        t.penalty.assign(cores, 0);
+        t.llc_misses.assign(cores, 0);
+    }
+}
+
+uint64_t MultiCoreSimulator::llc_hits() const {
+    uint64_t h = 0;
+    for (const Cache& s : slices) h += s.get_hits();
+    return h;
+}
+
+uint64_t MultiCoreSimulator::llc_misses() const {
+    uint64_t m = 0;
+    for (const Cache& s : slices) m += s.get_misses();
+    return m;
+}
+
+void MultiCoreSimulator::reset_stats() {
+    for (Core& c : core_state) {
+        c.stats = CoreStats{};
+        for (Cache& lv : c.levels) lv.reset_stats();
+    }
+    for (Cache& s : slices) s.reset_stats();
+}
+
+bool MultiCoreSimulator::next_address(Core& core, uint64_t& address) {
+    if (core.done) return false;
+    if (core.pos == core.chunk.count) {
+        if (!core.trace->next(core.chunk)) {
+            core.done = true;
+            return false;
+        }
+        core.pos = 0;
+    }
+    address = core.chunk.addresses[core.pos++];
+    return true;
+}
+
+uint64_t MultiCoreSimulator::probe_private(Core& core, uint64_t address, bool& llc) {
+    uint64_t latency = 0;
+    for (Cache& lv : core.levels) {
+        latency += lv.timing_params().hit_latency;
+        if (lv.lookup(address)) {
+            llc = false;
+            return latency;
+        }
+    }
+    llc = true;
+    return latency;
+}
+
+size_t MultiCoreSimulator::slice_of(uint64_t address, uint64_t& local) const {
+    const uint64_t line = address / line_size;
+    local = (line >> slice_shift) * line_size + address % line_size;
+    return static_cast<size_t>(line & ((uint64_t(1) << slice_shift) - 1));
+}
+
+void MultiCoreSimulator::run(const std::vector<TraceSource*>& traces, ThreadPool* pool) {
+    if (traces.size() != core_state.size()) {
+        throw std::invalid_argument("run() needs one trace per core");
+    }
+    for (size_t i = 0; i < traces.size(); i++) {
+        Core& c = core_state[i];
+        c.trace = traces[i];
+        c.chunk = TraceChunk{};
+        c.pos = 0;
+        c.done = false;
+    }
+
+    if (config.mode == MultiCoreConfig::Mode::Serialized) run_serialized();
+    else run_epochs(pool);
+}
+
+void MultiCoreSimulator::run_serialized() {
+    // (clock, core): the earliest core issues next, the lowest index on ties.
+    using Entry = std::pair<uint64_t, size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> ready;
+    for (size_t i = 0; i < core_state.size(); i++) ready.push({core_state[i].stats.cycles, i});
+
+    while (!ready.empty()) {
+        const size_t i = ready.top().second;
+        ready.pop();
+        Core& c = core_state[i];
+
+        uint64_t address;
+        if (!next_address(c, address)) continue;
+
+        bool llc = false;
+        uint64_t latency = probe_private(c, address, llc);
+        if (llc) {
+            uint64_t local;
+            Cache& slice = slices[slice_of(address, local)];
+            uint64_t llc_latency = 0;
+            const bool hit = slice.access(local, llc_latency);
+            latency += llc_latency;
+            c.stats.llc_accesses++;
+            c.stats.llc_misses += !hit;
+        }
+        c.stats.references++;
+        c.stats.cycles += latency;
+        ready.push({c.stats.cycles, i});
+    }
+}
+
+void MultiCoreSimulator::run_epochs(ThreadPool* pool) {
+    auto for_each = [pool](size_t n, const std::function<void(size_t)>& fn) {
+        if (pool && n > 1) {
+            pool->parallel_for(n, fn);
+        } else {
+            for (size_t i = 0; i < n; i++) fn(i);
+        }
+    };
+
+    for (;;) {
+        // The next epoch is the one holding the earliest clock still
+        // running, so cores that a long miss pushed far ahead skip epochs
+        // rather than idle through them.
+        bool any = false;
+        uint64_t earliest = 0;
+        for (const Core& c : core_state) {
+            if (c.done) continue;
+            if (!any || c.stats.cycles < earliest) earliest = c.stats.cycles;
+            any = true;
+        }
+        if (!any) break;
+        const uint64_t epoch_end = (earliest / config.quantum + 1) * config.quantum;
+
+        for_each(core_state.size(), [&](size_t i) { run_core_epoch(core_state[i], epoch_end); });
+        for_each(slices.size(), [&](size_t s) { run_slice_epoch(s); });
+
+        for (size_t s = 0; s < slices.size(); s++) {
+            SliceTally& t = tallies[s];
+            for (size_t i = 0; i < core_state.size(); i++) {
+                Core& c = core_state[i];
+                c.stats.cycles += t.penalty[i];
+                c.stats.llc_misses += t.llc_misses[i];
+                t.penalty[i] = 0;
+                t.llc_misses[i] = 0;
+                c.queued[s].clear();
+            }
+        }
+    }
+}
+
+void MultiCoreSimulator::run_core_epoch(Core& c, uint64_t epoch_end) {
+    uint64_t address;
+    while (c.stats.cycles < epoch_end && next_address(c, address)) {
+        bool llc = false;
+        uint64_t latency = probe_private(c, address, llc);
+        if (llc) {
+            uint64_t local;
+            const size_t s = slice_of(address, local);
+            c.queued[s].push_back(Request{c.stats.cycles, local});
+            c.stats.llc_accesses++;
+            latency += llc_hit_latency;     // assumed; corrected after the epoch
+        }
+        c.stats.references++;
+        c.stats.cycles += latency;
+    }
+}
+
+void MultiCoreSimulator::run_slice_epoch(size_t s) {
+    Cache& slice = slices[s];
+    SliceTally& t = tallies[s];
+
+    // Merge the cores' queues (each in issue order) by (time, core).
+    using Head = std::tuple<uint64_t, size_t, size_t>;     // time, core, position
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (size_t i = 0; i < core_state.size(); i++) {
+        const std::vector<Request>& q = core_state[i].queued[s];
+        if (!q.empty()) heads.push({q.front().time, i, 0});
+    }
+
+    while (!heads.empty()) {
+        const size_t i = std::get<1>(heads.top());
+        const size_t pos = std::get<2>(heads.top());
+        heads.pop();
+        const std::vector<Request>& q = core_state[i].queued[s];
+
+        uint64_t latency = 0;
+        const bool hit = slice.access(q[pos].address, latency);
+        t.penalty[i] += latency - llc_hit_latency;
+        t.llc_misses[i] += !hit;
+
+        if (pos + 1 < q.size()) heads.push({q[pos + 1].time, i, pos + 1});
+    }
+}
@@ -0,0 +1,158 @@
+#include "cache/replacement_policy.h"
+
+#include <cstring>
+#include <stdexcept>
+
+// Element i of a state array being validated; checkpoint data carries no
+// alignment guarantee beyond its own.
+template <typename T>
+static T element(const void* data, size_t i) {
+    T v;
+    std::memcpy(&v, static_cast<const uint8_t*>(data) + i * sizeof(T), sizeof(T));
+    return v;
+}
+
+const char* replacement_policy_name(ReplacementPolicy p) {
+    switch (p) {
+        case ReplacementPolicy::LRU:       return "LRU";
+        case ReplacementPolicy::FIFO:      return "FIFO";
+        case ReplacementPolicy::RANDOM:    return "RANDOM";
+        case ReplacementPolicy::TREE_PLRU: return "TREE_PLRU";
+        case ReplacementPolicy::BIT_PLRU:  return "BIT_PLRU";
+        case ReplacementPolicy::SRRIP:     return "SRRIP";
+        case ReplacementPolicy::BRRIP:     return "BRRIP";
+        default:                           return "UNKNOWN";
+    }
+}
+
+void LruPolicy::init(size_t num_sets, size_t ways) {
+    if (ways >= kNil) {
+        throw std::invalid_argument("LRU supports fewer than 2^32 - 1 ways");
+    }
+    this->ways = ways;
+    packed = ways <= kPackedWays;
+
+    // clear() rather than shrink: a reconfigured cache keeps the memory.
+    stack.clear();
+    prev.clear();
+    next.clear();
+    head.clear();
+    tail.clear();
+    if (packed) {
+        stack.resize(num_sets);
+    } else {
+        prev.resize(num_sets * ways);
+        next.resize(num_sets * ways);
+        head.resize(num_sets);
+        tail.resize(num_sets);
+    }
+    reset();
+}
+
+void LruPolicy::reset() {
+    // Any permutation works while a set fills; every way is promoted once
+    // before the set can need a victim.
+    std::fill(stack.begin(), stack.end(), kIdentity);
+    for (size_t s = 0; s < head.size(); s++) reset_set(s);
+}
+
+void LruPolicy::validate_state(const std::vector<const void*>& arrays) const {
+    if (packed) {
+        for (size_t s = 0; s < stack.size(); s++) {
+            const uint64_t word = element<uint64_t>(arrays.at(0), s);
+            unsigned seen = 0;
+            for (size_t pos = 0; pos < ways; pos++) {
+                const unsigned w = static_cast<unsigned>((word >> (4 * pos)) & 0xf);
+                if (w >= ways || (seen & (1u << w))) {
+                    throw std::invalid_argument("LRU recency stack is not a permutation of the ways");
+                }
+                seen |= 1u << w;
+            }
+        }
+        return;
+    }
+
+    std::vector<uint8_t> seen(ways);
+    for (size_t s = 0; s < head.size(); s++) {
+        const uint32_t h = element<uint32_t>(arrays.at(3), s);
+        const uint32_t t = element<uint32_t>(arrays.at(4), s);
+        std::fill(seen.begin(), seen.end(), 0);
+        uint32_t before = kNil;
+        size_t count = 0;
+        for (uint32_t w = h; w != kNil; w = element<uint32_t>(arrays.at(2), s * ways + w)) {
+            if (w >= ways || seen[w] || element<uint32_t>(arrays.at(1), s * ways + w) != before) {
+                throw std::invalid_argument("LRU recency list is corrupt");
+            }
+            seen[w] = 1;
+            before = w;
+            count++;
+        }
+        if (count != ways || before != t) {
+            throw std::invalid_argument("LRU recency list is corrupt");
+        }
+    }
+}
+
+void FifoPolicy::init(size_t num_sets, size_t ways) {
+    this->ways = ways;
+    next.assign(num_sets, 0);
+}
+
+void FifoPolicy::reset() {
+    std::fill(next.begin(), next.end(), 0);
+}
+
+void FifoPolicy::validate_state(const std::vector<const void*>& arrays) const {
+    for (size_t s = 0; s < next.size(); s++) {
+        if (element<uint32_t>(arrays.at(0), s) >= ways) {
+            throw std::invalid_argument("FIFO pointer out of range");
+        }
+    }
+}
+
+void TreePlruPolicy::init(size_t num_sets, size_t ways) {
+    if ((ways & (ways - 1)) != 0) {
+        throw std::invalid_argument("TREE_PLRU requires a power-of-two associativity");
+    }
+    this->ways = ways;
+    node.init(num_sets, ways);      // nodes 1..ways-1; bit 0 unused
+}
+
+void BitPlruPolicy::init(size_t num_sets, size_t ways) {
+    this->ways = ways;
+    this->num_sets = num_sets;
+    last_word_mask = (ways % 64 == 0) ? ~0ULL : (1ULL << (ways % 64)) - 1;
+    mru.init(num_sets, ways);
+    reset();
+}
+
+void BitPlruPolicy::reset() {
+    // Padding bits past the last way read as referenced, so victim() never
+    // returns them.
+    for (size_t s = 0; s < num_sets; s++) reset_set(s);
+}
+
+void BitPlruPolicy::validate_state(const std::vector<const void*>& arrays) const {
+    const size_t words = mru.words_per_set();
+    for (size_t s = 0; s < num_sets; s++) {
+        const uint64_t last = element<uint64_t>(arrays.at(0), s * words + words - 1);
+        if ((last & ~last_word_mask) != ~last_word_mask) {
+            throw std::invalid_argument("BIT_PLRU padding bits must be set");
+        }
+    }
+}
+
+void BitPlruPolicy::mark(size_t set, size_t way) {
+    uint64_t* r = mru.row(set);
+    SetBits::put(r, way, true);
+
+    const size_t words = mru.words_per_set();
+    for (size_t i = 0; i < words; i++) {
+        if (~r[i]) return;
+    }
+
+    // Every way is now marked: start a new round with only `way` set.
+    for (size_t i = 0; i < words; i++) r[i] = 0;
+    r[words - 1] = ~last_word_mask;
+    SetBits::put(r, way, true);
+}
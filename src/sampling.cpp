@@ -0,0 +1,98 @@
+#include "cache/sampling.h"
+#include "cache/cache_model.h"
+#include "cache/trace_source.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+SamplingController::SamplingController(Cache& cache, SamplingConfig config)
+    : cache(cache),
+      config(config)
+{
+    if (config.window == 0 || config.window > config.period) {
+        throw std::invalid_argument("sampling window must be > 0 and <= period");
+    }
+}
+
+void SamplingController::access_batch(const uint64_t* addresses, size_t count) {
+    const uint64_t warm_len = config.period - config.window;
+
+    while (count > 0) {
+        const uint64_t phase = position % config.period;
+        size_t n;
+        if (phase < warm_len) {
+            n = static_cast<size_t>(std::min<uint64_t>(count, warm_len - phase));
+            cache.warm(addresses, n);
+        } else {
+            if (!in_window) {
+                cache.reset_stats();
+                window_start = position;
+                in_window = true;
+            }
+            n = static_cast<size_t>(std::min<uint64_t>(count, config.period - phase));
+            cache.access_batch(addresses, n);
+            if (phase + n == config.period) close_window();
+        }
+        addresses += n;
+        count -= n;
+        position += n;
+    }
+}
+
+void SamplingController::run(TraceSource& source) {
+    TraceChunk chunk;
+    while (source.next(chunk)) access_batch(chunk.addresses, chunk.count);
+}
+
+void SamplingController::close_window() {
+    SampleWindow w;
+    w.start = window_start;
+    w.result = cache.functional_result();
+    w.amat = evaluate_timing(w.result, cache.timing_params()).amat;
+    windows.push_back(w);
+    in_window = false;
+}
+
+SamplingResult SamplingController::result(double z) const {
+    SamplingResult r;
+    r.windows = windows;
+    r.total_refs = position;
+    for (const SampleWindow& w : windows) r.measured_refs += w.result.accesses();
+
+    if (in_window) {
+        SampleWindow partial;
+        partial.start = window_start;
+        partial.result = cache.functional_result();
+        partial.amat = evaluate_timing(partial.result, cache.timing_params()).amat;
+        r.windows.push_back(partial);
+        r.measured_refs += partial.result.accesses();
+    }
+
+    const size_t n = windows.size();
+    if (n == 0) return r;
+
+    double mr_sum = 0.0, amat_sum = 0.0;
+    for (const SampleWindow& w : windows) {
+        mr_sum += w.result.miss_rate();
+        amat_sum += w.amat;
+    }
+    r.miss_rate = mr_sum / static_cast<double>(n);
+    r.amat = amat_sum / static_cast<double>(n);
+    if (n < 2) return r;
+
+    double mr_ss = 0.0, amat_ss = 0.0;
+    for (const SampleWindow& w : windows) {
+        mr_ss += (w.result.miss_rate() - r.miss_rate) * (w.result.miss_rate() - r.miss_rate);
+        amat_ss += (w.amat - r.amat) * (w.amat - r.amat);
+    }
+    const double population = static_cast<double>(position) / static_cast<double>(config.window);
+    const double fpc = std::max(0.0, 1.0 - static_cast<double>(n) / population);
+    const double mr_sd = std::sqrt(mr_ss / static_cast<double>(n - 1));
+    const double amat_sd = std::sqrt(amat_ss / static_cast<double>(n - 1));
+
+    r.miss_rate_ci = z * mr_sd * std::sqrt(fpc / static_cast<double>(n));
+    r.amat_ci = z * amat_sd * std::sqrt(fpc / static_cast<double>(n));
+    r.miss_rate_cv = r.miss_rate > 0.0 ? mr_sd / r.miss_rate : 0.0;
+    return r;
+}
@@ -0,0 +1,146 @@
+#include "cache/stack_distance.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+uint64_t MissRatioCurve::hits(size_t assoc) const {
+    if (assoc > distance_counts.size()) {
+        throw std::out_of_range("associativity exceeds the analyzed maximum");
+    }
+    uint64_t h = 0;
+    for (size_t d = 0; d < assoc; d++) h += distance_counts[d];
+    return h;
+}
+
+double MissRatioCurve::miss_rate(size_t assoc) const {
+    if (accesses == 0) return 0.0;
+    return static_cast<double>(misses(assoc)) / static_cast<double>(accesses);
+}
+
+StackDistanceAnalyzer::StackDistanceAnalyzer(size_t line_size,
+                                             std::vector<size_t> set_counts,
+                                             size_t max_assoc)
+    : line_size(line_size),
+      line_div(line_size),
+      max_assoc(max_assoc)
+{
+    if (line_size == 0 || max_assoc == 0) {
+        throw std::invalid_argument("line_size and max_assoc must be > 0");
+    }
+    if (set_counts.empty()) {
+        throw std::invalid_argument("at least one set count is required");
+    }
+
+    geometries.resize(set_counts.size());
+    for (size_t i = 0; i < set_counts.size(); i++) {
+        if (set_counts[i] == 0) {
+            throw std::invalid_argument("set counts must be > 0");
+        }
+        geometries[i].num_sets = set_counts[i];
+        geometries[i].set_div = FastDivider(set_counts[i]);
+        geometries[i].sets.resize(set_counts[i]);
+        geometries[i].hist.assign(max_assoc, 0);
+    }
+}
+
+void StackDistanceAnalyzer::fenwick_add(std::vector<uint32_t>& tree, uint32_t slot, int32_t delta) {
+    const size_t n = tree.size() - 1;
+    for (size_t i = static_cast<size_t>(slot) + 1; i <= n; i += i & (~i + 1)) {
+        tree[i] += static_cast<uint32_t>(delta);
+    }
+}
+
+uint32_t StackDistanceAnalyzer::fenwick_prefix(const std::vector<uint32_t>& tree, uint32_t slot) {
+    // Number of marks in slots [0, slot).
+    uint32_t sum = 0;
+    for (size_t i = slot; i > 0; i &= i - 1) sum += tree[i];
+    return sum;
+}
+
+void StackDistanceAnalyzer::compact(Geometry& g, SetStack& s) {
+    // Renumber live slots 0..live-1 in recency order and leave as much room
+    // again, so compaction is amortized O(1) per reference.
+    const uint32_t capacity = std::max<uint32_t>(16, 2 * s.live + 2);
+
+    std::vector<uint32_t> owner(capacity, kNoLine);
+    uint32_t k = 0;
+    for (uint32_t slot = 0; slot < s.next_slot; slot++) {
+        const uint32_t id = s.owner[slot];
+        if (id == kNoLine) continue;
+        owner[k] = id;
+        g.slot_of[id] = k;
+        k++;
+    }
+
+    // Linear-time Fenwick build over k leading ones.
+    std::vector<uint32_t> tree(static_cast<size_t>(capacity) + 1, 0);
+    for (size_t i = 1; i <= capacity; i++) {
+        if (i <= k) tree[i] += 1;
+        const size_t parent = i + (i & (~i + 1));
+        if (parent <= capacity) tree[parent] += tree[i];
+    }
+
+    s.owner.swap(owner);
+    s.tree.swap(tree);
+    s.next_slot = k;
+}
+
+void StackDistanceAnalyzer::touch(Geometry& g, uint64_t line, uint32_t id, bool first_touch) {
+    const uint64_t set = line - g.set_div.divide(line) * g.num_sets;
+    SetStack& s = g.sets[static_cast<size_t>(set)];
+
+    if (first_touch) {
+        g.cold++;
+    } else {
+        const uint32_t slot = g.slot_of[id];
+        const uint32_t distance = fenwick_prefix(s.tree, s.next_slot) - fenwick_prefix(s.tree, slot + 1);
+        if (distance < max_assoc) g.hist[distance]++;
+        else g.beyond++;
+
+        fenwick_add(s.tree, slot, -1);
+        s.owner[slot] = kNoLine;
+        s.live--;
+    }
+
+    if (s.next_slot + 1 >= s.tree.size()) compact(g, s);
+
+    const uint32_t slot = s.next_slot++;
+    fenwick_add(s.tree, slot, +1);
+    s.owner[slot] = id;
+    g.slot_of[id] = slot;
+    s.live++;
+}
+
+void StackDistanceAnalyzer::access(uint64_t address) {
+    accesses++;
+
+    const uint64_t line = line_div.divide(address);
+    const auto inserted = line_ids.try_emplace(line, static_cast<uint32_t>(line_ids.size()));
+    const uint32_t id = inserted.first->second;
+    const bool first_touch = inserted.second;
+
+    for (Geometry& g : geometries) {
+        if (first_touch) g.slot_of.push_back(0);
+        touch(g, line, id, first_touch);
+    }
+}
+
+void StackDistanceAnalyzer::access_batch(const uint64_t* addresses, size_t count) {
+    for (size_t i = 0; i < count; i++) access(addresses[i]);
+}
+
+std::vector<MissRatioCurve> StackDistanceAnalyzer::curves() const {
+    std::vector<MissRatioCurve> out;
+    out.reserve(geometries.size());
+    for (const Geometry& g : geometries) {
+        MissRatioCurve c;
+        c.line_size = line_size;
+        c.num_sets = g.num_sets;
+        c.accesses = accesses;
+        c.cold_misses = g.cold;
+        c.distance_counts = g.hist;
+        c.beyond = g.beyond;
+        out.push_back(std::move(c));
+    }
+    return out;
+}
@@ -0,0 +1,91 @@
+#include "cache/synthetic_trace.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+SyntheticTraceSource::SyntheticTraceSource(uint64_t length)
+    : length(length),
+      buf(static_cast<size_t>(std::min<uint64_t>(length, kSyntheticChunkRecords)))
+{
+}
+
+bool SyntheticTraceSource::next(TraceChunk& chunk) {
+    chunk = TraceChunk{};
+    if (position == length) return false;
+
+    const size_t n = static_cast<size_t>(std::min<uint64_t>(length - position, buf.size()));
+    fill(buf.data(), n);
+    position += n;
+    chunk.addresses = buf.data();
+    chunk.count = n;
+    return true;
+}
+
+void SyntheticTraceSource::rewind() {
+    position = 0;
+    restart();
+}
+
+// Addresses 0, step, ... below `bytes`.
+static uint64_t stream_length(uint64_t bytes, uint64_t step) {
+    if (step == 0) throw std::invalid_argument("trace step must be > 0");
+    return (bytes + step - 1) / step;
+}
+
+StreamTraceSource::StreamTraceSource(uint64_t bytes, uint64_t step_bytes)
+    : SyntheticTraceSource(stream_length(bytes, step_bytes)),
+      step(step_bytes)
+{
+}
+
+void StreamTraceSource::fill(uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = addr;
+        addr += step;
+    }
+}
+
+ReuseTraceSource::ReuseTraceSource(uint64_t working_set_bytes, uint64_t step_bytes, uint64_t passes)
+    : SyntheticTraceSource(stream_length(working_set_bytes, step_bytes) * passes),
+      working_set(working_set_bytes),
+      step(step_bytes)
+{
+}
+
+void ReuseTraceSource::fill(uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = addr;
+        addr += step;
+        if (addr >= working_set) addr = 0;
+    }
+}
+
+ConflictTraceSource::ConflictTraceSource(uint64_t spacing, uint64_t hot_lines, uint64_t accesses)
+    : SyntheticTraceSource(accesses),
+      spacing(spacing),
+      hot_lines(hot_lines)
+{
+    if (hot_lines == 0) throw std::invalid_argument("conflict trace needs at least one hot line");
+}
+
+void ConflictTraceSource::fill(uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = hot * spacing;
+        if (++hot == hot_lines) hot = 0;
+    }
+}
+
+StrideTraceSource::StrideTraceSource(uint64_t working_set_bytes, uint64_t stride_bytes, uint64_t accesses)
+    : SyntheticTraceSource(accesses),
+      working_set(working_set_bytes),
+      stride(stride_bytes)
+{
+    if (working_set_bytes == 0) throw std::invalid_argument("stride trace working set must be > 0");
+}
+
+void StrideTraceSource::fill(uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = addr;
+        addr = (addr + stride) % working_set;
+    }
+}
@@ -0,0 +1,98 @@
+#include "cache/tag_match.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CACHE_TAG_MATCH_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define CACHE_TAG_MATCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+uint64_t tag_match_scalar(const uint64_t* tags, size_t ways, uint64_t tag) {
+    uint64_t mask = 0;
+    for (size_t way = 0; way < ways; way++) {
+        mask |= static_cast<uint64_t>(tags[way] == tag) << way;
+    }
+    return mask;
+}
+
+#if defined(CACHE_TAG_MATCH_X86)
+
+__attribute__((target("avx2")))
+static uint64_t tag_match_avx2(const uint64_t* tags, size_t ways, uint64_t tag) {
+    const __m256i probe = _mm256_set1_epi64x(static_cast<long long>(tag));
+    uint64_t mask = 0;
+    size_t way = 0;
+    for (; way + 4 <= ways; way += 4) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + way));
+        const __m256i eq = _mm256_cmpeq_epi64(v, probe);
+        const uint64_t bits = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+        mask |= bits << way;
+    }
+    for (; way < ways; way++) {
+        mask |= static_cast<uint64_t>(tags[way] == tag) << way;
+    }
+    return mask;
+}
+
+__attribute__((target("avx512f")))
+static uint64_t tag_match_avx512(const uint64_t* tags, size_t ways, uint64_t tag) {
+    const __m512i probe = _mm512_set1_epi64(static_cast<long long>(tag));
+    uint64_t mask = 0;
+    for (size_t way = 0; way < ways; way += 8) {
+        const size_t n = (ways - way < 8) ? ways - way : 8;
+        const __mmask8 lanes = static_cast<__mmask8>((1u << n) - 1);
+        const __m512i v = _mm512_maskz_loadu_epi64(lanes, tags + way);
+        const __mmask8 eq = _mm512_mask_cmpeq_epi64_mask(lanes, v, probe);
+        mask |= static_cast<uint64_t>(eq) << way;
+    }
+    return mask;
+}
+
+#elif defined(CACHE_TAG_MATCH_NEON)
+
+static uint64_t tag_match_neon(const uint64_t* tags, size_t ways, uint64_t tag) {
+    const uint64x2_t probe = vdupq_n_u64(tag);
+    uint64_t mask = 0;
+    size_t way = 0;
+    for (; way + 2 <= ways; way += 2) {
+        const uint64x2_t eq = vceqq_u64(vld1q_u64(tags + way), probe);
+        mask |= (vgetq_lane_u64(eq, 0) & 1) << way;
+        mask |= (vgetq_lane_u64(eq, 1) & 1) << (way + 1);
+    }
+    for (; way < ways; way++) {
+        mask |= static_cast<uint64_t>(tags[way] == tag) << way;
+    }
+    return mask;
+}
+
+#endif
+
+namespace {
+
+struct TagMatchKernel {
+    TagMatchFn fn;
+    const char* name;
+};
+
+TagMatchKernel detect_kernel() {
+#if defined(CACHE_TAG_MATCH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return {tag_match_avx512, "avx512"};
+    if (__builtin_cpu_supports("avx2"))    return {tag_match_avx2, "avx2"};
+#elif defined(CACHE_TAG_MATCH_NEON)
+    return {tag_match_neon, "neon"};
+#endif
+    return {tag_match_scalar, "scalar"};
+}
+
+const TagMatchKernel& kernel() {
+    static const TagMatchKernel k = detect_kernel();
+    return k;
+}
+
+} // namespace
+
+TagMatchFn select_tag_match() { return kernel().fn; }
+
+const char* tag_match_isa_name() { return kernel().name; }
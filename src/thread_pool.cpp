@@ -0,0 +1,146 @@
+#include "cache/thread_pool.h"
+
+#include <exception>
+
+namespace {
+
+// Identifies the pool and worker slot of the current thread, so nested
+// submissions land on the submitting worker's own deque.
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local size_t tls_worker = 0;
+
+} // namespace
+
+size_t ThreadPool::default_thread_count() {
+    const unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : static_cast<size_t>(n);
+}
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) num_threads = default_thread_count();
+
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+
+    threads.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+        threads.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void ThreadPool::enqueue(Task task) {
+    const size_t target = (tls_pool == this)
+        ? tls_worker
+        : next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    {
+        // Count the task before it becomes visible so `queued` never dips
+        // below the number of tasks actually sitting in deques; publishing
+        // under wake_mutex means a worker about to sleep cannot miss it.
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        queued.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::try_pop(size_t self, Task& task) {
+    Worker& w = *workers[self];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty()) return false;
+    task = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::try_steal(size_t self, Task& task) {
+    const size_t n = workers.size();
+    for (size_t k = 1; k < n; k++) {
+        Worker& victim = *workers[(self + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t self) {
+    tls_pool = this;
+    tls_worker = self;
+
+    for (;;) {
+        Task task;
+        if (try_pop(self, task) || try_steal(self, task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 0) return;
+
+    // Helpers and the caller pull indices from a shared counter. Helpers that
+    // only start after the range is exhausted exit immediately, so the caller
+    // waits on completed indices rather than on the helper tasks themselves.
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+        const std::function<void(size_t)>* fn = nullptr;
+        size_t n = 0;
+    };
+    auto state = std::make_shared<State>();
+    state->fn = &fn;
+    state->n = n;
+
+    auto drain = [](State& s) {
+        for (;;) {
+            const size_t i = s.next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= s.n) return;
+            try {
+                (*s.fn)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (!s.error) s.error = std::current_exception();
+            }
+            if (s.done.fetch_add(1, std::memory_order_acq_rel) + 1 == s.n) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = (n - 1 < workers.size()) ? n - 1 : workers.size();
+    for (size_t h = 0; h < helpers; h++) {
+        enqueue([state, drain] { drain(*state); });
+    }
+
+    drain(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load(std::memory_order_acquire) == n; });
+    if (state->error) std::rethrow_exception(state->error);
+}
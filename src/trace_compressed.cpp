@@ -0,0 +1,220 @@
+#include "cache/trace_compressed.h"
+
+#include <cstring>
+#include <stdexcept>
+
+static const char kFileMagic[8] = {'C', 'M', 'Z', 'T', 'R', 'A', 'C', 'E'};
+static const char kChunkMagic[4] = {'C', 'M', 'Z', 'C'};
+
+static uint64_t zigzag_encode(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t u) {
+    return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+}
+
+static size_t padded8(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+// -----------------------------
+// Writer
+// -----------------------------
+
+CompressedTraceWriter::CompressedTraceWriter(const std::string& path, uint32_t chunk_records)
+    : out(path, std::ios::binary | std::ios::trunc),
+      chunk_records(chunk_records)
+{
+    if (!out) {
+        throw std::runtime_error("cannot open trace file for writing: " + path);
+    }
+    if (chunk_records == 0) {
+        throw std::invalid_argument("chunk_records must be > 0");
+    }
+
+    // Placeholder header; record_count is patched in by close().
+    const CompressedTraceHeader blank{};
+    out.write(reinterpret_cast<const char*>(&blank), sizeof(blank));
+
+    addresses.reserve(chunk_records);
+    types.reserve(chunk_records);
+}
+
+CompressedTraceWriter::~CompressedTraceWriter() {
+    if (!closed) {
+        try {
+            close();
+        } catch (...) {
+            // Destructors must not throw; call close() to observe errors.
+        }
+    }
+}
+
+void CompressedTraceWriter::append(uint64_t address, AccessType type) {
+    addresses.push_back(address);
+    types.push_back(static_cast<uint8_t>(type));
+    record_count++;
+
+    if (addresses.size() == chunk_records) flush_chunk();
+}
+
+void CompressedTraceWriter::flush_chunk() {
+    const size_t n = addresses.size();
+    if (n == 0) return;
+
+    encoded.clear();
+    for (size_t i = 1; i < n; i++) {
+        uint64_t u = zigzag_encode(static_cast<int64_t>(addresses[i] - addresses[i - 1]));
+        while (u >= 0x80) {
+            encoded.push_back(static_cast<uint8_t>(u | 0x80));
+            u >>= 7;
+        }
+        encoded.push_back(static_cast<uint8_t>(u));
+    }
+    const size_t address_bytes = encoded.size();
+
+    bool any_write = false;
+    for (uint8_t t : types) any_write |= (t != 0);
+    size_t type_bytes = 0;
+    if (any_write) {
+        type_bytes = (n + 7) / 8;
+        encoded.resize(address_bytes + type_bytes, 0);
+        for (size_t i = 0; i < n; i++) {
+            if (types[i]) encoded[address_bytes + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    }
+    encoded.resize(padded8(encoded.size()), 0);
+
+    CompressedChunkHeader ch{};
+    std::memcpy(ch.magic, kChunkMagic, sizeof(kChunkMagic));
+    ch.count = static_cast<uint32_t>(n);
+    ch.first_address = addresses[0];
+    ch.address_bytes = static_cast<uint32_t>(address_bytes);
+    ch.type_bytes = static_cast<uint32_t>(type_bytes);
+
+    out.write(reinterpret_cast<const char*>(&ch), sizeof(ch));
+    out.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+
+    addresses.clear();
+    types.clear();
+}
+
+void CompressedTraceWriter::close() {
+    if (closed) return;
+    closed = true;
+
+    flush_chunk();
+
+    CompressedTraceHeader header{};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kCompressedTraceVersion;
+    header.chunk_records = chunk_records;
+    header.record_count = record_count;
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("failed to write trace file");
+    }
+}
+
+// -----------------------------
+// Reader
+// -----------------------------
+
+CompressedTraceReader::CompressedTraceReader(const std::string& path)
+    : file(path, /*sequential=*/true)
+{
+    if (file.size() < sizeof(CompressedTraceHeader)) {
+        throw std::runtime_error("trace file too small: " + path);
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+        header.version != kCompressedTraceVersion) {
+        throw std::runtime_error("not a version-1 .cmz trace: " + path);
+    }
+
+    // Walk the chunk headers once to build the seek index.
+    uint64_t records = 0;
+    size_t offset = sizeof(CompressedTraceHeader);
+    while (records < header.record_count) {
+        if (offset + sizeof(CompressedChunkHeader) > file.size()) {
+            throw std::runtime_error("truncated trace file: " + path);
+        }
+        CompressedChunkHeader ch;
+        std::memcpy(&ch, file.data() + offset, sizeof(ch));
+        // decode_chunk trusts these: the type bitmap is absent or exactly
+        // one bit per record, and chunks sum to exactly record_count.
+        const uint64_t bitmap_bytes = (static_cast<uint64_t>(ch.count) + 7) / 8;
+        if (std::memcmp(ch.magic, kChunkMagic, sizeof(kChunkMagic)) != 0 || ch.count == 0 ||
+            (ch.type_bytes != 0 && ch.type_bytes != bitmap_bytes) ||
+            ch.count > header.record_count - records) {
+            throw std::runtime_error("corrupt chunk header in trace file: " + path);
+        }
+
+        const size_t payload = padded8(static_cast<size_t>(ch.address_bytes) + ch.type_bytes);
+        if (offset + sizeof(ch) + payload > file.size()) {
+            throw std::runtime_error("truncated trace file: " + path);
+        }
+
+        chunk_offsets.push_back(offset);
+        records += ch.count;
+        offset += sizeof(ch) + payload;
+    }
+}
+
+void CompressedTraceReader::decode_chunk(size_t i,
+                                         std::vector<uint64_t>& addresses,
+                                         std::vector<uint8_t>& types) const {
+    const uint8_t* p = file.data() + chunk_offsets.at(i);
+    CompressedChunkHeader ch;
+    std::memcpy(&ch, p, sizeof(ch));
+    p += sizeof(ch);
+
+    const size_t n = ch.count;
+    addresses.resize(n);
+    types.resize(n);
+
+    const uint8_t* in = p;
+    const uint8_t* in_end = p + ch.address_bytes;
+    uint64_t* out = addresses.data();
+
+    uint64_t addr = ch.first_address;
+    out[0] = addr;
+    for (size_t k = 1; k < n; k++) {
+        uint64_t u = 0;
+        unsigned shift = 0;
+        uint8_t byte;
+        do {
+            if (in == in_end || shift > 63) {
+                throw std::runtime_error("corrupt address stream in trace chunk");
+            }
+            byte = *in++;
+            u |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        addr += static_cast<uint64_t>(zigzag_decode(u));
+        out[k] = addr;
+    }
+
+    if (ch.type_bytes == 0) {
+        std::memset(types.data(), 0, n);
+    } else {
+        const uint8_t* bits = p + ch.address_bytes;
+        for (size_t k = 0; k < n; k++) types[k] = (bits[k / 8] >> (k % 8)) & 1;
+    }
+}
+
+bool CompressedTraceReader::next(TraceChunk& chunk) {
+    chunk = TraceChunk{};
+    if (next_chunk >= chunk_offsets.size()) return false;
+
+    decode_chunk(next_chunk++, addr_buf, type_buf);
+    chunk.addresses = addr_buf.data();
+    chunk.types = type_buf.data();
+    chunk.count = addr_buf.size();
+    return true;
+}
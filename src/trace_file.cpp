@@ -0,0 +1,168 @@
+#include "cache/trace_file.h"
+
+#include <cstring>
+#include <stdexcept>
+
+static const char kTraceMagic[8] = {'C', 'M', 'T', 'R', 'A', 'C', 'E', '1'};
+
+static size_t align8(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+size_t trace_block_bytes(uint32_t flags, size_t n) {
+    size_t bytes = n * sizeof(uint64_t) + align8(n);
+    if (flags & kTraceHasPc) bytes += n * sizeof(uint64_t);
+    if (flags & kTraceHasThreadId) bytes += align8(n * sizeof(uint32_t));
+    return bytes;
+}
+
+// -----------------------------
+// Writer
+// -----------------------------
+
+TraceFileWriter::TraceFileWriter(const std::string& path, uint32_t flags, uint32_t block_records)
+    : out(path, std::ios::binary | std::ios::trunc),
+      flags(flags),
+      block_records(block_records)
+{
+    if (!out) {
+        throw std::runtime_error("cannot open trace file for writing: " + path);
+    }
+    if (block_records == 0) {
+        throw std::invalid_argument("block_records must be > 0");
+    }
+
+    // Placeholder header; record_count is patched in by close().
+    const TraceFileHeader blank{};
+    out.write(reinterpret_cast<const char*>(&blank), sizeof(blank));
+
+    addresses.reserve(block_records);
+    types.reserve(block_records);
+    if (flags & kTraceHasPc) pcs.reserve(block_records);
+    if (flags & kTraceHasThreadId) thread_ids.reserve(block_records);
+}
+
+TraceFileWriter::~TraceFileWriter() {
+    if (!closed) {
+        try {
+            close();
+        } catch (...) {
+            // Destructors must not throw; call close() to observe errors.
+        }
+    }
+}
+
+void TraceFileWriter::append(uint64_t address, AccessType type, uint64_t pc, uint32_t thread_id) {
+    addresses.push_back(address);
+    types.push_back(static_cast<uint8_t>(type));
+    if (flags & kTraceHasPc) pcs.push_back(pc);
+    if (flags & kTraceHasThreadId) thread_ids.push_back(thread_id);
+    record_count++;
+
+    if (addresses.size() == block_records) flush_block();
+}
+
+void TraceFileWriter::flush_block() {
+    const size_t n = addresses.size();
+    if (n == 0) return;
+
+    static const char zeros[8] = {};
+    auto write_padded = [&](const void* data, size_t bytes) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        out.write(zeros, static_cast<std::streamsize>(align8(bytes) - bytes));
+    };
+
+    write_padded(addresses.data(), n * sizeof(uint64_t));
+    write_padded(types.data(), n);
+    if (flags & kTraceHasPc) write_padded(pcs.data(), n * sizeof(uint64_t));
+    if (flags & kTraceHasThreadId) write_padded(thread_ids.data(), n * sizeof(uint32_t));
+
+    addresses.clear();
+    types.clear();
+    pcs.clear();
+    thread_ids.clear();
+}
+
+void TraceFileWriter::close() {
+    if (closed) return;
+    closed = true;
+
+    flush_block();
+
+    TraceFileHeader header{};
+    std::memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+    header.version = kTraceFileVersion;
+    header.flags = flags;
+    header.record_count = record_count;
+    header.block_records = block_records;
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("failed to write trace file");
+    }
+}
+
+// -----------------------------
+// Reader
+// -----------------------------
+
+MappedTraceReader::MappedTraceReader(const std::string& path)
+    : file(path, /*sequential=*/true)
+{
+    if (file.size() < sizeof(TraceFileHeader)) {
+        throw std::runtime_error("trace file too small: " + path);
+    }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) != 0 ||
+        header.version != kTraceFileVersion || header.block_records == 0) {
+        throw std::runtime_error("not a version-1 .cmt trace: " + path);
+    }
+
+    // record_count comes from the file, so size the blocks by division:
+    // a product or sum of it could wrap and pass the truncation check.
+    const uint64_t full_blocks = header.record_count / header.block_records;
+    const size_t tail = static_cast<size_t>(header.record_count % header.block_records);
+    const uint64_t block_bytes = trace_block_bytes(header.flags, header.block_records);
+    const uint64_t tail_bytes = trace_block_bytes(header.flags, tail);
+    const uint64_t body = file.size() - sizeof(TraceFileHeader);
+    if (tail_bytes > body || full_blocks > (body - tail_bytes) / block_bytes) {
+        throw std::runtime_error("truncated trace file: " + path);
+    }
+    num_blocks = static_cast<size_t>(full_blocks + (tail != 0));
+}
+
+TraceChunk MappedTraceReader::block(size_t i) const {
+    TraceChunk chunk;
+    if (i >= num_blocks) return chunk;
+
+    const size_t per_block = header.block_records;
+    const size_t n = (i + 1 < num_blocks)
+        ? per_block
+        : static_cast<size_t>(header.record_count - static_cast<uint64_t>(i) * per_block);
+
+    const uint8_t* p = file.data() + sizeof(TraceFileHeader) + i * trace_block_bytes(header.flags, per_block);
+
+    chunk.count = n;
+    chunk.addresses = reinterpret_cast<const uint64_t*>(p);
+    p += n * sizeof(uint64_t);
+    chunk.types = p;
+    p += align8(n);
+    if (header.flags & kTraceHasPc) {
+        chunk.pcs = reinterpret_cast<const uint64_t*>(p);
+        p += n * sizeof(uint64_t);
+    }
+    if (header.flags & kTraceHasThreadId) {
+        chunk.thread_ids = reinterpret_cast<const uint32_t*>(p);
+    }
+    return chunk;
+}
+
+bool MappedTraceReader::next(TraceChunk& chunk) {
+    chunk = block(next_block);
+    if (chunk.count == 0) return false;
+    next_block++;
+    return true;
+}
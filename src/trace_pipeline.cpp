@@ -0,0 +1,145 @@
+#include "cache/trace_pipeline.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Copies `n` entries of an optional column; returns null when absent.
+template <typename T>
+static const T* copy_column(const T* src, size_t n, std::vector<T>& dst) {
+    if (!src) return nullptr;
+    dst.resize(std::max(dst.size(), n));
+    std::copy(src, src + n, dst.begin());
+    return dst.data();
+}
+
+static size_t check_depth(size_t depth) {
+    if (depth == 0) throw std::invalid_argument("prefetch depth must be > 0");
+    return depth;
+}
+
+PrefetchingTraceSource::PrefetchingTraceSource(TraceSource& inner, size_t depth)
+    : inner(inner),
+      slots(check_depth(depth)),
+      free_slots(depth),
+      full_slots(depth + 1)     // every slot plus the end marker
+{
+    start();
+}
+
+PrefetchingTraceSource::~PrefetchingTraceSource() {
+    stop();
+}
+
+void PrefetchingTraceSource::start() {
+    for (size_t i = 0; i < slots.size(); i++) free_slots.try_push(static_cast<uint32_t>(i));
+    held = kNoSlot;
+    ended = false;
+    error = nullptr;
+    stopping.store(false, std::memory_order_relaxed);
+    thread = std::thread([this] { produce(); });
+}
+
+// The waiter publishes its flag and then re-checks the ring; the waker
+// publishes the ring entry and then checks the flag. The seq_cst fences
+// on both sides mean at least one of them sees the other, and the waker
+// notifies under the mutex, so the wakeup cannot fall between the
+// waiter's last check and its wait.
+template <typename Ready>
+void PrefetchingTraceSource::wait_until(std::atomic<bool>& waiting, Ready ready) {
+    for (int i = 0; i < kSpinRounds; i++) {
+        if (ready()) return;
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeup.wait(lock, ready);
+    waiting.store(false, std::memory_order_relaxed);
+}
+
+void PrefetchingTraceSource::wake(const std::atomic<bool>& waiting) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!waiting.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    wakeup.notify_all();
+}
+
+void PrefetchingTraceSource::stop() {
+    if (!thread.joinable()) return;
+    stopping.store(true, std::memory_order_release);
+    wake(producer_waiting);
+    thread.join();
+
+    // Both threads are quiet now; take every slot back so the rings are empty.
+    uint32_t slot;
+    while (full_slots.try_pop(slot)) {}
+    while (free_slots.try_pop(slot)) {}
+}
+
+void PrefetchingTraceSource::produce() {
+    try {
+        TraceChunk in;
+        while (!stopping.load(std::memory_order_acquire) && inner.next(in)) {
+            uint32_t slot = kNoSlot;
+            if (!free_slots.try_pop(slot)) {
+                pwaits.fetch_add(1, std::memory_order_relaxed);
+                wait_until(producer_waiting, [&] {
+                    return stopping.load(std::memory_order_acquire) || free_slots.try_pop(slot);
+                });
+                if (stopping.load(std::memory_order_acquire)) return;
+            }
+
+            Slot& s = slots[slot];
+            TraceChunk& out = s.chunk;
+            out.count = in.count;
+            out.addresses = copy_column(in.addresses, in.count, s.addresses);
+            out.types = copy_column(in.types, in.count, s.types);
+            out.pcs = copy_column(in.pcs, in.count, s.pcs);
+            out.thread_ids = copy_column(in.thread_ids, in.count, s.thread_ids);
+
+            // Never fails: at most slots.size() slots are in flight.
+            full_slots.try_push(slot);
+            wake(consumer_waiting);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // The ring holds one entry more than there are slots.
+    full_slots.try_push(kEnd);
+    wake(consumer_waiting);
+}
+
+bool PrefetchingTraceSource::next(TraceChunk& chunk) {
+    chunk = TraceChunk{};
+    if (held != kNoSlot) {
+        free_slots.try_push(held);
+        held = kNoSlot;
+        wake(producer_waiting);
+    }
+    if (ended) return false;
+
+    uint32_t slot;
+    if (!full_slots.try_pop(slot)) {
+        cwaits++;
+        wait_until(consumer_waiting, [&] { return full_slots.try_pop(slot); });
+    }
+    if (slot == kEnd) {
+        ended = true;
+        if (error) {
+            std::exception_ptr e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+        return false;
+    }
+
+    held = slot;
+    chunk = slots[slot].chunk;
+    return true;
+}
+
+void PrefetchingTraceSource::rewind() {
+    stop();
+    inner.rewind();
+    start();
+}
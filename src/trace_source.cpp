@@ -0,0 +1,29 @@
+#include "cache/trace_source.h"
+#include "cache/cache_model.h"
+#include "cache/trace_compressed.h"
+#include "cache/trace_file.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+std::unique_ptr<TraceSource> open_trace_file(const std::string& path) {
+    char magic[8] = {};
+    std::ifstream in(path, std::ios::binary);
+    if (!in.read(magic, sizeof(magic))) {
+        throw std::runtime_error("cannot read trace file: " + path);
+    }
+
+    if (std::memcmp(magic, "CMTRACE1", 8) == 0) return std::make_unique<MappedTraceReader>(path);
+    if (std::memcmp(magic, "CMZTRACE", 8) == 0) return std::make_unique<CompressedTraceReader>(path);
+    throw std::runtime_error("unrecognized trace file format: " + path);
+}
+
+BatchStats simulate_trace(Cache& cache, TraceSource& source) {
+    BatchStats total;
+    TraceChunk chunk;
+    while (source.next(chunk)) {
+        total += cache.access_batch(chunk.addresses, chunk.count, chunk.types);
+    }
+    return total;
+}